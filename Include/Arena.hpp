@@ -0,0 +1,182 @@
+#ifndef ABM_ARENA_HPP
+#define ABM_ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace ABM
+{
+/**
+ * @brief Monotonic memory arena for short-lived temporaries.
+ * Memory is handed out by bumping an offset inside big blocks and is
+ * released all at once, either by a Scope or by reset(). Blocks are kept
+ * for reuse, so a warmed up arena doesn't touch the global heap. Not
+ * thread-safe: every thread is supposed to have its own arena
+ */
+class Arena
+{
+  struct Marker
+  {
+    std::size_t block;
+    std::size_t offset;
+  };
+
+public:
+  /**
+   * @brief Releases everything allocated during its lifetime on destruction
+   */
+  class Scope
+  {
+  public:
+    explicit Scope(Arena & arena) noexcept : arena(arena), marker(arena.getMarker()) { }
+    ~Scope()
+    {
+      arena.rewind(marker);
+    }
+
+    Scope(const Scope &) = delete;
+    Scope & operator=(const Scope &) = delete;
+
+  private:
+    Arena & arena;
+    const Marker marker;
+  };
+
+  explicit Arena(std::size_t blockSize = 64 * 1024) : blockSize(blockSize) { }
+
+  Arena(const Arena &) = delete;
+  Arena & operator=(const Arena &) = delete;
+
+  /**
+   * @brief Allocates memory that stays valid until the arena is rewound
+   * @param alignment - power of two
+   */
+  void * allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t))
+  {
+    if (currentBlock < blocks.size())
+    {
+      auto & block = blocks[currentBlock];
+      const auto address = reinterpret_cast<std::uintptr_t>(block.data.get()) + offset;
+      const auto padding = (alignment - address % alignment) % alignment;
+
+      if (offset + padding + size <= block.size)
+      {
+        offset += padding + size;
+
+        return reinterpret_cast<void *>(address + padding);
+      }
+    }
+
+    return allocateInNextBlock(size, alignment);
+  }
+
+  /**
+   * @brief Gives memory back only if it was the most recent allocation,
+   * otherwise it's released when the arena is rewound
+   */
+  void deallocate(void * pointer, std::size_t size) noexcept
+  {
+    if (currentBlock < blocks.size())
+    {
+      auto data = blocks[currentBlock].data.get();
+
+      if (static_cast<char *>(pointer) + size == data + offset)
+      {
+        offset = static_cast<std::size_t>(static_cast<char *>(pointer) - data);
+      }
+    }
+  }
+
+  /**
+   * @brief Releases all allocations, keeping the blocks
+   */
+  void reset() noexcept
+  {
+    currentBlock = 0;
+    offset = 0;
+  }
+
+  /**
+   * @brief Returns number of bytes taken from the heap
+   */
+  std::size_t getCapacity() const noexcept;
+
+private:
+  struct Block
+  {
+    std::unique_ptr<char[]> data;
+    std::size_t size;
+  };
+
+  void * allocateInNextBlock(std::size_t size, std::size_t alignment);
+
+  Marker getMarker() const noexcept
+  {
+    return { currentBlock, offset };
+  }
+
+  void rewind(const Marker & marker) noexcept
+  {
+    currentBlock = marker.block;
+    offset = marker.offset;
+  }
+
+  const std::size_t blockSize;
+  std::vector<Block> blocks;
+  std::size_t currentBlock = 0;
+  std::size_t offset = 0;
+};
+
+/**
+ * @brief Standard allocator on top of an Arena
+ */
+template<typename T>
+class ArenaAllocator
+{
+public:
+  using value_type = T;
+
+  ArenaAllocator(Arena & arena) noexcept : arena(& arena) { }
+
+  template<typename U>
+  ArenaAllocator(const ArenaAllocator<U> & allocator) noexcept : arena(allocator.getArena()) { }
+
+  T * allocate(std::size_t count)
+  {
+    return static_cast<T *>(arena->allocate(count * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T * pointer, std::size_t count) noexcept
+  {
+    arena->deallocate(pointer, count * sizeof(T));
+  }
+
+  Arena * getArena() const noexcept
+  {
+    return arena;
+  }
+
+private:
+  Arena * arena;
+};
+
+template<typename T, typename U>
+bool operator==(const ArenaAllocator<T> & left, const ArenaAllocator<U> & right) noexcept
+{
+  return left.getArena() == right.getArena();
+}
+
+template<typename T, typename U>
+bool operator!=(const ArenaAllocator<T> & left, const ArenaAllocator<U> & right) noexcept
+{
+  return !(left == right);
+}
+
+template<typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+}
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef ABM_BARRIER_HPP
+#define ABM_BARRIER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace ABM
+{
+/**
+ * @brief Reusable barrier for a fixed number of threads.
+ * Sense-reversing: the last thread to arrive resets the counter and flips
+ * the phase that the others are waiting on. Waiting threads spin for a
+ * while first, since phases of a frame are usually short, and then block
+ */
+class Barrier
+{
+public:
+  explicit Barrier(std::size_t count,
+                   std::chrono::microseconds spinDuration = std::chrono::microseconds{100})
+    : count(count), spinDuration(spinDuration), remaining(count) { }
+
+  Barrier(const Barrier &) = delete;
+  Barrier & operator=(const Barrier &) = delete;
+
+  /**
+   * @brief Blocks until all of the threads arrive
+   * @return True for exactly one thread per phase, the last one to arrive.
+   * It can do serial work while the others proceed
+   */
+  bool arriveAndWait()
+  {
+    const auto currentPhase = phase.load(std::memory_order_acquire);
+
+    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      remaining.store(count, std::memory_order_relaxed);
+
+      {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        phase.store(currentPhase + 1, std::memory_order_release);
+      }
+
+      if (sleepers.load(std::memory_order_relaxed) != 0)
+      {
+        condition.notify_all();
+      }
+
+      return true;
+    }
+
+    const auto spinEnd = std::chrono::steady_clock::now() + spinDuration;
+
+    while (phase.load(std::memory_order_acquire) == currentPhase)
+    {
+      if (std::chrono::steady_clock::now() >= spinEnd)
+      {
+        std::unique_lock<std::mutex> lock{mutex};
+
+        // Registered under the lock, so the last thread either sees it or
+        // has already flipped the phase
+        sleepers.fetch_add(1, std::memory_order_relaxed);
+        condition.wait(lock, [this, currentPhase]
+        {
+          return phase.load(std::memory_order_acquire) != currentPhase;
+        });
+        sleepers.fetch_sub(1, std::memory_order_relaxed);
+
+        break;
+      }
+
+      std::this_thread::yield();
+    }
+
+    return false;
+  }
+
+  std::size_t getCount() const noexcept
+  {
+    return count;
+  }
+
+private:
+  const std::size_t count;
+  const std::chrono::microseconds spinDuration;
+  std::atomic<std::size_t> remaining;
+  std::atomic<std::uint64_t> phase{0};
+  std::atomic<std::size_t> sleepers{0};
+  std::mutex mutex;
+  std::condition_variable condition;
+};
+}
+
+#endif
@@ -2,11 +2,18 @@
 #define ABM_COMPONENTS_HPP
 
 #include <bitset>
+#include <cstdint>
 
-#include <SFML/Graphics.hpp>
+#include <SFML/System/Vector2.hpp>
 
 namespace ABM
 {
+// Identifier of an Agent that, unlike its index, doesn't change during its life
+struct Identity
+{
+  std::uint64_t id = 0;
+};
+
 struct Destination
 {
   Destination() = default;
@@ -27,26 +34,31 @@ struct Orientation
   float viewRange = 0;
 };
 
-// Graphical representation of an Agent
+// Graphical representation of an Agent. Holds only the data the shape is
+// built from when it's drawn, so the simulation doesn't depend on graphics
 struct Graphic
 {
-  Graphic()
+  /**
+   * @brief Packs a color into RGBA integer
+   */
+  static constexpr std::uint32_t rgb(std::uint8_t red, std::uint8_t green,
+                                     std::uint8_t blue) noexcept
   {
-    const float width = 20.f;
-    const float height = 40.f;
-
-    // Triangle shape with a yellow fill
-    shape.setPointCount(3);
-    shape.setPoint(0, { width / 2, 0.f });
-    shape.setPoint(1, { 0.f, height });
-    shape.setPoint(2, { width, height });
-
-    shape.setFillColor(sf::Color::Yellow);
-
-    shape.setOrigin(width / 2, height / 2);
+    return (std::uint32_t{red} << 24) | (std::uint32_t{green} << 16) |
+           (std::uint32_t{blue} << 8) | 0xff;
   }
 
-  sf::ConvexShape shape;
+  static constexpr std::uint32_t yellow = 0xffff00ff;
+  static constexpr std::uint32_t green = 0x00ff00ff;
+  static constexpr std::uint32_t blue = 0x0000ffff;
+
+  // Fill color, RGBA
+  std::uint32_t color = yellow;
+  // Clock-wise, in degrees
+  float rotation = 0;
+  // Positions at the two latest ticks, drawing is interpolated between them
+  sf::Vector2f previousPosition;
+  sf::Vector2f position;
 };
 
 // Life energy of an Agent
@@ -0,0 +1,400 @@
+#ifndef ABM_COROUTINE_HPP
+#define ABM_COROUTINE_HPP
+
+// Coroutines need C++20, configure with -DABM_COROUTINES=ON to enable them
+#if defined(__cpp_impl_coroutine)
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+#include <vector>
+#include <thread>
+#include <cassert>
+
+#include "ThreadPool.hpp"
+
+namespace ABM
+{
+template<typename T = void>
+class AsyncTask;
+
+namespace Detail
+{
+/**
+ * @brief Passes control to the coroutine that awaits a finished task
+ */
+struct FinalAwaiter
+{
+  bool await_ready() const noexcept
+  {
+    return false;
+  }
+
+  template<typename TPromise>
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<TPromise> handle) noexcept
+  {
+    const auto continuation = handle.promise().continuation;
+
+    return continuation ? continuation : std::noop_coroutine();
+  }
+
+  void await_resume() const noexcept { }
+};
+
+/**
+ * @brief Part of a task's promise that doesn't depend on type of the result
+ */
+struct PromiseBase
+{
+  // Tasks are lazy: they start when awaited
+  std::suspend_always initial_suspend() const noexcept
+  {
+    return {};
+  }
+
+  FinalAwaiter final_suspend() const noexcept
+  {
+    return {};
+  }
+
+  void unhandled_exception() noexcept
+  {
+    exception = std::current_exception();
+  }
+
+  void rethrowIfFailed() const
+  {
+    if (exception)
+    {
+      std::rethrow_exception(exception);
+    }
+  }
+
+  std::coroutine_handle<> continuation;
+  std::exception_ptr exception;
+};
+
+template<typename T>
+struct Promise : PromiseBase
+{
+  AsyncTask<T> get_return_object() noexcept;
+
+  template<typename TValue>
+  void return_value(TValue && value)
+  {
+    result.emplace(std::forward<TValue>(value));
+  }
+
+  T takeResult()
+  {
+    rethrowIfFailed();
+
+    return std::move(*result);
+  }
+
+  std::optional<T> result;
+};
+
+template<>
+struct Promise<void> : PromiseBase
+{
+  AsyncTask<void> get_return_object() noexcept;
+
+  void return_void() noexcept { }
+
+  void takeResult() const
+  {
+    rethrowIfFailed();
+  }
+};
+
+/**
+ * @brief Counts finished tasks and resumes the awaiting coroutine, if any,
+ * after the last one
+ */
+struct Completion
+{
+  explicit Completion(std::size_t count) : pending(count) { }
+
+  void notify()
+  {
+    // The completion may be gone as soon as the counter reaches zero
+    const auto awaiting = continuation;
+
+    if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1 && awaiting)
+    {
+      awaiting.resume();
+    }
+  }
+
+  std::atomic<std::size_t> pending;
+  std::coroutine_handle<> continuation;
+};
+
+/**
+ * @brief Coroutine that destroys itself when finished. Used to observe
+ * tasks without taking their results
+ */
+class Notifier
+{
+public:
+  struct promise_type
+  {
+    Notifier get_return_object() noexcept
+    {
+      return Notifier{std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+
+    std::suspend_always initial_suspend() const noexcept
+    {
+      return {};
+    }
+
+    std::suspend_never final_suspend() const noexcept
+    {
+      return {};
+    }
+
+    void return_void() noexcept { }
+
+    void unhandled_exception() noexcept
+    {
+      std::terminate();
+    }
+  };
+
+  void start()
+  {
+    handle.resume();
+  }
+
+private:
+  explicit Notifier(std::coroutine_handle<promise_type> handle) noexcept
+    : handle(handle) { }
+
+  std::coroutine_handle<promise_type> handle;
+};
+
+template<typename T>
+Notifier notifyWhenReady(AsyncTask<T> & task, Completion & completion)
+{
+  co_await task.whenReady();
+
+  completion.notify();
+}
+
+/**
+ * @brief Starts all of the tasks and resumes the awaiting coroutine when
+ * they are finished
+ */
+template<typename T>
+class WhenAllAwaiter
+{
+public:
+  explicit WhenAllAwaiter(std::vector<AsyncTask<T>> & tasks)
+    : tasks(tasks), completion(tasks.size() + 1) { }
+
+  bool await_ready() const noexcept
+  {
+    return tasks.empty();
+  }
+
+  bool await_suspend(std::coroutine_handle<> handle)
+  {
+    completion.continuation = handle;
+
+    for (auto & task : tasks)
+    {
+      notifyWhenReady(task, completion).start();
+    }
+
+    // Don't suspend if all of the tasks have already finished
+    return completion.pending.fetch_sub(1, std::memory_order_acq_rel) != 1;
+  }
+
+  void await_resume() const noexcept { }
+
+private:
+  std::vector<AsyncTask<T>> & tasks;
+  Completion completion;
+};
+}
+
+/**
+ * @brief Lazily started asynchronous operation. Starts when awaited and
+ * resumes the awaiting coroutine when finished. Combined with
+ * ThreadPool::schedule() the operation runs on the pool's workers
+ */
+template<typename T>
+class AsyncTask
+{
+public:
+  using promise_type = Detail::Promise<T>;
+
+  AsyncTask() noexcept = default;
+  explicit AsyncTask(std::coroutine_handle<promise_type> handle) noexcept
+    : handle(handle) { }
+
+  AsyncTask(AsyncTask && task) noexcept : handle(std::exchange(task.handle, nullptr)) { }
+
+  AsyncTask & operator=(AsyncTask && task) noexcept
+  {
+    if (this != & task)
+    {
+      if (handle)
+      {
+        handle.destroy();
+      }
+
+      handle = std::exchange(task.handle, nullptr);
+    }
+
+    return *this;
+  }
+
+  AsyncTask(const AsyncTask &) = delete;
+  AsyncTask & operator=(const AsyncTask &) = delete;
+
+  ~AsyncTask()
+  {
+    if (handle)
+    {
+      handle.destroy();
+    }
+  }
+
+  bool isReady() const noexcept
+  {
+    return !handle || handle.done();
+  }
+
+  auto operator co_await() noexcept
+  {
+    struct Awaiter : ReadyAwaiter
+    {
+      T await_resume()
+      {
+        return this->handle.promise().takeResult();
+      }
+    };
+
+    return Awaiter{{handle}};
+  }
+
+  /**
+   * @brief Returns an awaitable that waits for the task but doesn't take
+   * its result or exception
+   */
+  auto whenReady() noexcept
+  {
+    return ReadyAwaiter{handle};
+  }
+
+  /**
+   * @brief Returns result of a finished task or rethrows its exception
+   */
+  T getResult()
+  {
+    assert(handle && handle.done());
+
+    return handle.promise().takeResult();
+  }
+
+private:
+  struct ReadyAwaiter
+  {
+    bool await_ready() const noexcept
+    {
+      return handle.done();
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+      handle.promise().continuation = awaiting;
+
+      return handle;
+    }
+
+    void await_resume() const noexcept { }
+
+    std::coroutine_handle<promise_type> handle;
+  };
+
+  std::coroutine_handle<promise_type> handle;
+};
+
+namespace Detail
+{
+template<typename T>
+AsyncTask<T> Promise<T>::get_return_object() noexcept
+{
+  return AsyncTask<T>{std::coroutine_handle<Promise<T>>::from_promise(*this)};
+}
+
+inline AsyncTask<void> Promise<void>::get_return_object() noexcept
+{
+  return AsyncTask<void>{std::coroutine_handle<Promise<void>>::from_promise(*this)};
+}
+}
+
+/**
+ * @brief Runs tasks concurrently and collects their results in the same order
+ */
+template<typename T>
+AsyncTask<std::vector<T>> whenAll(std::vector<AsyncTask<T>> tasks)
+{
+  co_await Detail::WhenAllAwaiter<T>{tasks};
+
+  std::vector<T> results;
+
+  results.reserve(tasks.size());
+
+  for (auto & task : tasks)
+  {
+    results.push_back(task.getResult());
+  }
+
+  co_return results;
+}
+
+/**
+ * @brief Runs tasks concurrently and waits for all of them
+ */
+inline AsyncTask<void> whenAll(std::vector<AsyncTask<void>> tasks)
+{
+  co_await Detail::WhenAllAwaiter<void>{tasks};
+
+  for (auto & task : tasks)
+  {
+    task.getResult();
+  }
+}
+
+/**
+ * @brief Runs a task from regular code and blocks until it's finished.
+ * The calling thread executes pending tasks of the pool meanwhile
+ */
+template<typename T>
+T syncWait(ThreadPool & threadPool, AsyncTask<T> task)
+{
+  Detail::Completion completion{1};
+
+  Detail::notifyWhenReady(task, completion).start();
+
+  while (completion.pending.load(std::memory_order_acquire) != 0)
+  {
+    if (!threadPool.runPendingTask())
+    {
+      std::this_thread::yield();
+    }
+  }
+
+  return task.getResult();
+}
+}
+
+#endif
+
+#endif
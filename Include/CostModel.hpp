@@ -0,0 +1,100 @@
+#ifndef ABM_COST_MODEL_HPP
+#define ABM_COST_MODEL_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace ABM
+{
+/**
+ * @brief Estimated cost of processing every block of a range of elements,
+ * e.g. agents. A new block is estimated from its weight, such as the number
+ * of agents in it that match a signature, and then from measured durations
+ * of the chunks that covered it. Measured costs follow changes of weights.
+ * Used to split the range into partitions of equal cost instead of equal
+ * length
+ */
+class CostModel
+{
+public:
+  explicit CostModel(std::size_t blockSize = 64);
+
+  std::size_t getBlockSize() const noexcept
+  {
+    return blockSize;
+  }
+
+  std::size_t getBlocksCount() const noexcept
+  {
+    return blocks.size();
+  }
+
+  /**
+   * @brief Adapts the model to a new number of elements. Weights of all of
+   * the blocks have to be updated afterwards, since elements move between
+   * blocks
+   */
+  void resize(std::size_t count);
+
+  /**
+   * @brief Adapts the model to a new number of elements and updates weights
+   * of all of the blocks on the calling thread
+   */
+  template<typename TWeight>
+  void resize(std::size_t count, TWeight && weight)
+  {
+    resize(count);
+    updateWeights(0, blocks.size(), std::forward<TWeight>(weight));
+  }
+
+  /**
+   * @brief Sets weight(first, last) as the weight of every block in
+   * [firstBlock, lastBlock). Different threads can update different blocks
+   * @param firstBlock - index of the first block
+   * @param lastBlock - index past the last block
+   */
+  template<typename TWeight>
+  void updateWeights(std::size_t firstBlock, std::size_t lastBlock, TWeight && weight)
+  {
+    for (auto i = firstBlock; i < lastBlock; ++i)
+    {
+      setWeight(i, static_cast<double>(weight(i * blockSize,
+                                              std::min((i + 1) * blockSize, elementsCount))));
+    }
+  }
+
+  /**
+   * @brief Reports duration of processing [first, last). Chunks processed
+   * concurrently must not share blocks, i.e. their bounds have to be
+   * multiples of the block size
+   */
+  void record(std::size_t first, std::size_t last, std::chrono::nanoseconds duration) noexcept;
+
+  /**
+   * @brief Splits [first, last) into partitions of about equal estimated
+   * cost. Boundaries are aligned to blocks
+   * @param boundaries - receives partsCount + 1 boundaries of partitions
+   */
+  void split(std::size_t first, std::size_t last, std::size_t partsCount,
+             std::vector<std::size_t> & boundaries) const;
+
+private:
+  void setWeight(std::size_t block, double weight) noexcept;
+
+  struct Block
+  {
+    double weight = 0;
+    // Smoothed duration in nanoseconds, negative until measured
+    double cost = -1;
+  };
+
+  const std::size_t blockSize;
+  std::size_t elementsCount = 0;
+  std::vector<Block> blocks;
+};
+}
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef ABM_ENERGY_SOURCES_HPP
+#define ABM_ENERGY_SOURCES_HPP
+
+#include <cassert>
+#include <vector>
+
+#include <SFML/System/Vector2.hpp>
+
+namespace ABM
+{
+/**
+ * @brief Sources of energy stored column by column: levels, capacities,
+ * regeneration rates and coordinates are kept in separate arrays. Passes
+ * over all of the sources, like regeneration, load only the columns they
+ * use and can be vectorized
+ */
+class EnergySources
+{
+public:
+  void resize(std::size_t count);
+  void set(std::size_t index, float maxCapacity, float currentLevel,
+           float regenerationRate, sf::Vector2f position);
+
+  std::size_t size() const noexcept { return levels.size(); }
+
+  float getRegenerationRate(std::size_t index) const { return at(rates, index); }
+  float getMaxCapacity(std::size_t index) const { return at(capacities, index); }
+
+  float getCurrentLevel(std::size_t index) const { return at(levels, index); }
+  void setCurrentLevel(std::size_t index, float value);
+
+  sf::Vector2f getPosition(std::size_t index) const
+  {
+    return { at(xs, index), at(ys, index) };
+  }
+
+  void regenerate(std::size_t first, std::size_t last, float delta) noexcept;
+  float reset(std::size_t index);
+
+private:
+  static float at(const std::vector<float> & column, std::size_t index)
+  {
+    assert(index < column.size());
+
+    return column[index];
+  }
+
+  std::vector<float> levels;
+  std::vector<float> capacities;
+  std::vector<float> rates;
+  std::vector<float> xs;
+  std::vector<float> ys;
+};
+}
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef ABM_FIXED_TIMESTEP_HPP
+#define ABM_FIXED_TIMESTEP_HPP
+
+#include <cstddef>
+
+namespace ABM
+{
+/**
+ * @brief Turns elapsed real time into a number of simulation ticks of a
+ * fixed duration. Time that is not enough for a whole tick is accumulated
+ * for the next frames and tells how far rendering should be interpolated
+ * between the last two ticks
+ */
+class FixedTimestep
+{
+public:
+  /**
+   * @brief C-tor
+   * @param tickDuration - simulated time of a tick, in seconds
+   * @param maxSubSteps - maximum number of ticks per frame. Time beyond
+   * that is dropped, so slow frames don't make the simulation fall further
+   * and further behind
+   */
+  explicit FixedTimestep(float tickDuration = 1.f / 60.f, std::size_t maxSubSteps = 8);
+
+  /**
+   * @brief Accounts for real time elapsed since the previous call
+   * @return Number of ticks to simulate now
+   */
+  std::size_t advance(float elapsed) noexcept;
+
+  /**
+   * @brief Returns the part of a tick that is accumulated but not simulated
+   * yet, in range [0, 1)
+   */
+  float getInterpolation() const noexcept
+  {
+    return accumulator / tickDuration;
+  }
+
+  void setTickDuration(float duration) noexcept;
+
+  float getTickDuration() const noexcept
+  {
+    return tickDuration;
+  }
+
+  void setMaxSubSteps(std::size_t count) noexcept;
+
+  std::size_t getMaxSubSteps() const noexcept
+  {
+    return maxSubSteps;
+  }
+
+  /**
+   * @brief Stops or resumes accumulating time. Nothing is simulated while
+   * paused
+   */
+  void setPaused(bool paused) noexcept
+  {
+    this->paused = paused;
+  }
+
+  bool isPaused() const noexcept
+  {
+    return paused;
+  }
+
+private:
+  float tickDuration;
+  std::size_t maxSubSteps;
+  float accumulator = 0;
+  bool paused = false;
+};
+}
+
+#endif
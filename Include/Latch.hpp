@@ -0,0 +1,47 @@
+#ifndef ABM_LATCH_HPP
+#define ABM_LATCH_HPP
+
+#include <atomic>
+#include <thread>
+
+namespace ABM
+{
+/**
+ * @brief Single-use countdown latch. Threads count it down as they finish
+ * their part of the work and the owner waits until it reaches zero
+ */
+class CountdownLatch
+{
+public:
+  explicit CountdownLatch(std::size_t count) : count(count) { }
+
+  CountdownLatch(const CountdownLatch &) = delete;
+  CountdownLatch & operator=(const CountdownLatch &) = delete;
+
+  void countDown() noexcept
+  {
+    count.fetch_sub(1, std::memory_order_release);
+  }
+
+  bool isReady() const noexcept
+  {
+    return count.load(std::memory_order_acquire) == 0;
+  }
+
+  /**
+   * @brief Blocks until the counter reaches zero
+   */
+  void wait() const noexcept
+  {
+    while (!isReady())
+    {
+      std::this_thread::yield();
+    }
+  }
+
+private:
+  std::atomic<std::size_t> count;
+};
+}
+
+#endif
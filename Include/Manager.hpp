@@ -3,6 +3,7 @@
 
 #define VALUE_TYPE(T) typename decltype(T)::type
 
+#include <algorithm>
 #include <vector>
 #include <tuple>
 #include <cassert>
@@ -220,6 +221,37 @@ public:
     return newIndex;
   }
 
+  /**
+   * @brief Creates a given number of Agents at once. Memory is allocated a
+   * single time, and as indexes are contiguous, components of new Agents can
+   * be added from different threads, one thread per Agent
+   * @param count - number of Agents
+   * @return Index of the first Agent
+   */
+  std::size_t createIndexes(std::size_t count)
+  {
+    const auto first = nextSize;
+
+    if (first + count > capacity)
+    {
+      growTo(std::max((capacity + 10) * 2, first + count));
+    }
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      auto & agent = agents[first + i];
+
+      assert(!agent.alive);
+
+      agent.alive = true;
+      agent.bitset.reset();
+    }
+
+    nextSize += count;
+
+    return first;
+  }
+
   /**
    * @brief Checks if an Agent with a given index is alive
    * @param index - index of an Agent
@@ -287,7 +319,7 @@ public:
    * @brief Helper function that executes a given functor for all agents
    */
   template<typename TFunc>
-  void forAll(TFunc && func) noexcept
+  void forAll(TFunc && func) const noexcept
   {
     for (std::size_t i = 0; i < size; ++i)
     {
@@ -300,7 +332,7 @@ public:
    * of agents
    */
   template<typename TFunc>
-  void forGroup(std::size_t first, std::size_t last, TFunc func) noexcept
+  void forGroup(std::size_t first, std::size_t last, TFunc func) const noexcept
   {
     for ( ; first < last; ++first)
     {
@@ -313,7 +345,7 @@ public:
    * that matche a specific Signature
    */
   template<typename TSignature, typename TFunc>
-  void forAllMatching(TFunc && func) noexcept
+  void forAllMatching(TFunc && func) const noexcept
   {
     forAll([this, & func](std::size_t index)
     {
@@ -329,7 +361,7 @@ public:
    * of agents that match a specific Signature
    */
   template<typename TSignature, typename TFunc>
-  void forGroupMatching(std::size_t first, std::size_t last, TFunc && func) noexcept
+  void forGroupMatching(std::size_t first, std::size_t last, TFunc && func) const noexcept
   {
     forGroup(first, last, [this, & func](std::size_t index)
     {
@@ -340,6 +372,23 @@ public:
     });
   }
 
+  /**
+   * @brief Returns number of agents in a specified group that match a
+   * specific Signature
+   */
+  template<typename TSignature>
+  std::size_t countMatching(std::size_t first, std::size_t last) const noexcept
+  {
+    std::size_t count = 0;
+
+    for ( ; first < last; ++first)
+    {
+      count += matchesSignature<TSignature>(first) ? 1 : 0;
+    }
+
+    return count;
+  }
+
   /**
    * @brief Returns actual number of active agents
    */
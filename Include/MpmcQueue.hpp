@@ -0,0 +1,203 @@
+#ifndef ABM_MPMC_QUEUE_HPP
+#define ABM_MPMC_QUEUE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <cassert>
+
+namespace ABM
+{
+/**
+ * @brief Bounded lock-free multi-producer multi-consumer queue.
+ * Array-based ring where every cell carries a sequence number telling
+ * whether it's free for a producer or ready for a consumer
+ */
+template<typename T>
+class MpmcQueue
+{
+public:
+  explicit MpmcQueue(std::size_t capacity = 4096)
+    : capacity(capacity), mask(capacity - 1), cells(new Cell[capacity])
+  {
+    assert(capacity != 0 && (capacity & mask) == 0);
+
+    for (std::size_t i = 0; i < capacity; ++i)
+    {
+      cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MpmcQueue(const MpmcQueue &) = delete;
+  MpmcQueue & operator=(const MpmcQueue &) = delete;
+
+  /**
+   * @brief Adds an element to the queue
+   * @return False if the queue is full. The value is left untouched then
+   */
+  bool tryPush(T && value)
+  {
+    auto position = enqueuePosition.load(std::memory_order_relaxed);
+
+    while (true)
+    {
+      auto & cell = cells[position & mask];
+      const auto sequence = cell.sequence.load(std::memory_order_acquire);
+      const auto difference = static_cast<std::intptr_t>(sequence) -
+                              static_cast<std::intptr_t>(position);
+
+      if (difference == 0)
+      {
+        if (enqueuePosition.compare_exchange_weak(position, position + 1,
+                                                  std::memory_order_relaxed))
+        {
+          cell.value = std::move(value);
+          cell.sequence.store(position + 1, std::memory_order_release);
+
+          return true;
+        }
+      }
+      else if (difference < 0)
+      {
+        return false;
+      }
+      else
+      {
+        position = enqueuePosition.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * @brief Adds a number of elements at once. All of the cells are reserved
+   * with a single atomic operation
+   * @return False if there's not enough space for all of them. The values
+   * are left untouched then
+   */
+  bool tryPushBatch(T * values, std::size_t count)
+  {
+    if (count > capacity)
+    {
+      return false;
+    }
+
+    auto position = enqueuePosition.load(std::memory_order_relaxed);
+
+    while (true)
+    {
+      const auto dequeue = dequeuePosition.load(std::memory_order_acquire);
+
+      // Position is outdated
+      if (dequeue > position)
+      {
+        position = enqueuePosition.load(std::memory_order_relaxed);
+
+        continue;
+      }
+
+      if (position + count - dequeue > capacity)
+      {
+        return false;
+      }
+
+      if (enqueuePosition.compare_exchange_weak(position, position + count,
+                                                std::memory_order_relaxed))
+      {
+        break;
+      }
+    }
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      auto & cell = cells[(position + i) & mask];
+
+      // A consumer that has already claimed the previous element of this
+      // cell may still be moving it out
+      while (cell.sequence.load(std::memory_order_acquire) != position + i)
+      {
+        std::this_thread::yield();
+      }
+
+      cell.value = std::move(values[i]);
+      cell.sequence.store(position + i + 1, std::memory_order_release);
+    }
+
+    return true;
+  }
+
+  /**
+   * @brief Takes the oldest element from the queue
+   * @return False if the queue is empty
+   */
+  bool tryPop(T & value)
+  {
+    auto position = dequeuePosition.load(std::memory_order_relaxed);
+
+    while (true)
+    {
+      auto & cell = cells[position & mask];
+      const auto sequence = cell.sequence.load(std::memory_order_acquire);
+      const auto difference = static_cast<std::intptr_t>(sequence) -
+                              static_cast<std::intptr_t>(position + 1);
+
+      if (difference == 0)
+      {
+        if (dequeuePosition.compare_exchange_weak(position, position + 1,
+                                                  std::memory_order_relaxed))
+        {
+          value = std::move(cell.value);
+          cell.sequence.store(position + capacity, std::memory_order_release);
+
+          return true;
+        }
+      }
+      else if (difference < 0)
+      {
+        return false;
+      }
+      else
+      {
+        position = dequeuePosition.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * @brief Returns approximate number of elements, including the ones that
+   * are being added right now
+   */
+  std::size_t size() const noexcept
+  {
+    const auto dequeue = dequeuePosition.load();
+    const auto enqueue = enqueuePosition.load();
+
+    return enqueue > dequeue ? enqueue - dequeue : 0;
+  }
+
+  bool empty() const noexcept
+  {
+    return size() == 0;
+  }
+
+private:
+  struct Cell
+  {
+    std::atomic<std::size_t> sequence;
+    T value;
+  };
+
+  const std::size_t capacity;
+  const std::size_t mask;
+  std::unique_ptr<Cell[]> cells;
+
+  // Keep positions on separate cache lines so producers and consumers
+  // don't disturb each other
+  char enqueuePadding[64];
+  std::atomic<std::size_t> enqueuePosition{0};
+  char dequeuePadding[64 - sizeof(std::atomic<std::size_t>)];
+  std::atomic<std::size_t> dequeuePosition{0};
+};
+}
+
+#endif
@@ -0,0 +1,202 @@
+#ifndef ABM_PIPELINE_HPP
+#define ABM_PIPELINE_HPP
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+#include "Manager.hpp"
+
+namespace ABM
+{
+/**
+ * @brief Ordered set of systems that are executed chunk by chunk.
+ * Instead of sweeping all agents once per system, all systems of a group
+ * are applied to one chunk of agents before moving to the next chunk, while
+ * the chunk's components are still in cache. Systems are split into groups
+ * according to the components they declare to access
+ */
+template<typename TSettings>
+class Pipeline
+{
+public:
+  using Bitset = typename TSettings::Bitset;
+
+  // Components a system accesses
+  struct Access
+  {
+    // Components of the agent being processed
+    Bitset reads;
+    Bitset writes;
+    // Components of any other agents, e.g. neighbors
+    Bitset readsOthers;
+  };
+
+  /**
+   * @brief Returns a set of given Components
+   */
+  template<typename... TComponents>
+  static Bitset components() noexcept
+  {
+    Bitset bitset;
+
+    (void)std::initializer_list<int>{
+      (bitset.set(TSettings::template componentID<TComponents>()), 0)...
+    };
+
+    return bitset;
+  }
+
+  /**
+   * @brief Determines if a system can run chunk by chunk together with a
+   * system that goes before it. That's not the case if either of them reads
+   * components of other agents that the other one writes: some of those
+   * agents would already be processed by the first system and some not yet
+   */
+  static bool canFuse(const Access & previous, const Access & next) noexcept
+  {
+    return (previous.writes & next.readsOthers).none() &&
+           (next.writes & previous.readsOthers).none();
+  }
+
+  explicit Pipeline(Manager<TSettings> & manager) : manager(manager) { }
+
+  Pipeline(const Pipeline &) = delete;
+  Pipeline & operator=(const Pipeline &) = delete;
+
+  /**
+   * @brief Appends a system that executes func(index) for agents matching
+   * a specific Signature
+   * @return Index of the system
+   */
+  template<typename TSignature, typename TFunc>
+  std::size_t addSystem(const Access & access, TFunc func)
+  {
+    systems.push_back({ access, [this, func](std::size_t first, std::size_t last)
+    {
+      manager.template forGroupMatching<TSignature>(first, last, func);
+    }, [this](std::size_t first, std::size_t last)
+    {
+      return manager.template countMatching<TSignature>(first, last);
+    } });
+
+    const auto index = systems.size() - 1;
+    const auto fits = !groups.empty() &&
+                      std::all_of(groups.back().begin(), groups.back().end(),
+                                  [this, & access](std::size_t system)
+    {
+      return canFuse(systems[system].access, access);
+    });
+
+    if (!fits)
+    {
+      groups.emplace_back();
+    }
+
+    groups.back().push_back(index);
+
+    return index;
+  }
+
+  /**
+   * @brief Returns indexes of systems of every group. Groups have to be
+   * executed one after another over all agents
+   */
+  const std::vector<std::vector<std::size_t>> & getGroups() const noexcept
+  {
+    return groups;
+  }
+
+  /**
+   * @brief Returns index of a group that contains a given system
+   */
+  std::size_t getGroupOf(std::size_t system) const noexcept
+  {
+    for (std::size_t i = 0; i < groups.size(); ++i)
+    {
+      if (std::find(groups[i].begin(), groups[i].end(), system) != groups[i].end())
+      {
+        return i;
+      }
+    }
+
+    return groups.size();
+  }
+
+  /**
+   * @brief Returns how many agents have all components used by a group
+   * fit into a given number of bytes
+   */
+  std::size_t getChunkSize(std::size_t group, std::size_t bytes) const
+  {
+    Bitset used;
+
+    for (const auto system : groups[group])
+    {
+      used |= systems[system].access.reads | systems[system].access.writes;
+    }
+
+    std::size_t agentSize = 0;
+
+    brigand::for_each<typename TSettings::ComponentList>([& agentSize, & used](auto type)
+    {
+      using Component = typename decltype(type)::type;
+
+      if (used[TSettings::template componentID<Component>()])
+      {
+        agentSize += sizeof(Component);
+      }
+    });
+
+    return std::max<std::size_t>(bytes / std::max<std::size_t>(agentSize, 1), 1);
+  }
+
+  std::size_t getSystemsCount() const noexcept
+  {
+    return systems.size();
+  }
+
+  /**
+   * @brief Executes a single system for a range of agents
+   */
+  void runSystem(std::size_t system, std::size_t first, std::size_t last) const
+  {
+    systems[system].process(first, last);
+  }
+
+  /**
+   * @brief Returns number of agents in a range that a system processes
+   */
+  std::size_t countMatching(std::size_t system, std::size_t first, std::size_t last) const
+  {
+    return systems[system].count(first, last);
+  }
+
+  /**
+   * @brief Executes all systems of a group, one after another, for a chunk
+   * of agents
+   */
+  void runGroup(std::size_t group, std::size_t first, std::size_t last) const
+  {
+    for (const auto system : groups[group])
+    {
+      systems[system].process(first, last);
+    }
+  }
+
+private:
+  struct System
+  {
+    Access access;
+    std::function<void(std::size_t, std::size_t)> process;
+    std::function<std::size_t(std::size_t, std::size_t)> count;
+  };
+
+  Manager<TSettings> & manager;
+  std::vector<System> systems;
+  std::vector<std::vector<std::size_t>> groups;
+};
+}
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef ABM_RANDOM_HPP
+#define ABM_RANDOM_HPP
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+
+#include <SFML/System/Vector2.hpp>
+
+namespace ABM
+{
+/**
+ * @brief Philox4x32-10 counter-based generator. A block of random values is
+ * a pure function of a counter and a key, so any block can be computed
+ * independently, from any thread, without shared state
+ */
+class Philox
+{
+public:
+  using Counter = std::array<std::uint32_t, 4>;
+  using Key = std::array<std::uint32_t, 2>;
+
+  static Counter generate(Counter counter, Key key) noexcept
+  {
+    for (int round = 0; round < 10; ++round)
+    {
+      const auto product0 = std::uint64_t{multiplier0} * counter[0];
+      const auto product1 = std::uint64_t{multiplier1} * counter[2];
+
+      counter = {{
+        static_cast<std::uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+        static_cast<std::uint32_t>(product1),
+        static_cast<std::uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+        static_cast<std::uint32_t>(product0)
+      }};
+
+      key[0] += weyl0;
+      key[1] += weyl1;
+    }
+
+    return counter;
+  }
+
+private:
+  static constexpr std::uint32_t multiplier0 = 0xD2511F53;
+  static constexpr std::uint32_t multiplier1 = 0xCD9E8D57;
+  static constexpr std::uint32_t weyl0 = 0x9E3779B9;
+  static constexpr std::uint32_t weyl1 = 0xBB67AE85;
+};
+
+/**
+ * @brief Random values of one entity at one tick. Streams with different
+ * domains, entities or ticks don't overlap, and the same stream always
+ * yields the same values, no matter which thread draws them and when
+ */
+class RandomStream
+{
+public:
+  // What values are drawn for, so e.g. agent 5 and source 5, or creation
+  // and movement of the same agent, get independent values
+  enum class Domain : std::uint8_t
+  {
+    AgentCreation,
+    AgentMovement,
+    EnergySourceCreation
+  };
+
+  RandomStream(std::uint64_t seed, Domain domain, std::uint64_t entity,
+               std::uint32_t tick) noexcept
+    : key{{ static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32) }},
+      counter{{ static_cast<std::uint32_t>(entity), static_cast<std::uint32_t>(entity >> 32),
+                tick, static_cast<std::uint32_t>(domain) << 24 }}
+  {
+  }
+
+  std::uint32_t next() noexcept
+  {
+    if (position == block.size())
+    {
+      block = Philox::generate(counter, key);
+      // The lower 24 bits count blocks within the stream
+      ++counter[3];
+      position = 0;
+    }
+
+    return block[position++];
+  }
+
+  /**
+   * @brief Returns a number in range [minValue, maxValue)
+   */
+  float uniform(float minValue, float maxValue) noexcept
+  {
+    // 24 bits fill the mantissa of a float
+    const auto unit = static_cast<float>(next() >> 8) * (1.f / 16777216.f);
+
+    return minValue + (maxValue - minValue) * unit;
+  }
+
+  sf::Vector2f uniformVector(float minValue, float maxValue) noexcept
+  {
+    const auto x = uniform(minValue, maxValue);
+
+    return { x, uniform(minValue, maxValue) };
+  }
+
+  bool bernoulli(float probability) noexcept
+  {
+    return uniform(0.f, 1.f) < probability;
+  }
+
+  /**
+   * @brief Returns a bitset where every bit is set with a given probability
+   */
+  template<std::size_t size>
+  std::bitset<size> bitset(float probability) noexcept
+  {
+    std::bitset<size> bits;
+
+    for (std::size_t i = 0; i < size; ++i)
+    {
+      bits[i] = bernoulli(probability);
+    }
+
+    return bits;
+  }
+
+private:
+  Philox::Key key;
+  Philox::Counter counter;
+  Philox::Counter block{};
+  std::size_t position = block.size();
+};
+}
+
+#endif
@@ -0,0 +1,290 @@
+#ifndef ABM_SIMULATION_HPP
+#define ABM_SIMULATION_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+#include "Barrier.hpp"
+#include "CostModel.hpp"
+#include "Pipeline.hpp"
+#include "Tuner.hpp"
+#include "ThreadPool.hpp"
+#include "Manager.hpp"
+#include "Components.hpp"
+#include "EnergySources.hpp"
+#include "Random.hpp"
+
+namespace ABM
+{
+using AgentComponents = ComponentList<Identity, Orientation, Energy, Destination, Graphic,
+  Information>;
+
+using Movement = Signature<Orientation, Destination>;
+using Life = Signature<Energy>;
+using Harvesting = Signature<Orientation, Destination, Energy>;
+using InfoCollection = Signature<Orientation, Information>;
+using Render = Signature<Orientation, Destination, Graphic>;
+using EnergyIndication = Signature<Energy, Graphic>;
+using InfoIndication = Signature<Information, Graphic>;
+using AgentSignatures = SignatureList<Movement, Life, Harvesting, InfoCollection,
+  Render, EnergyIndication, InfoIndication>;
+
+using AgentSettings = Settings<AgentComponents, AgentSignatures>;
+
+struct SimulationOptions
+{
+  sf::Vector2f worldSize{ 5000.f, 5000.f };
+  std::size_t maxAgentsNumber = 6000;
+  // Agents spawned when the world is built, the rest are spawned during ticks
+  std::size_t initialAgentsNumber = 0;
+  std::size_t maxSourcesNumber = 500;
+  // Zero stands for the number of hardware threads
+  std::size_t threadsNumber = 0;
+  // Population changes a lot, so by default the pool finds the number of
+  // workers that actually pays off. Fixed pools make timings comparable
+  bool elastic = true;
+  // Seed of random values. A random one is used unless it's set. Runs with
+  // the same seed are the same regardless of the number of threads
+  bool seeded = false;
+  std::uint64_t seed = 0;
+};
+
+/**
+ * @brief The world of agents and energy sources together with the systems
+ * that update it. Has no dependency on windows or graphics, so it can be
+ * run either by Application or headless
+ */
+class Simulation
+{
+public:
+  explicit Simulation(const SimulationOptions & options = SimulationOptions());
+
+  Simulation(const Simulation &) = delete;
+  Simulation & operator=(const Simulation &) = delete;
+
+  /**
+   * @brief Advances the world by one tick
+   * @param delta - simulated time of the tick, in seconds
+   */
+  void tick(float delta);
+
+  /**
+   * @brief Switches to the next way of executing the update in parallel
+   */
+  void switchUpdateMode();
+
+  std::string getUpdateModeName() const;
+
+  const Manager<AgentSettings> & getAgentManager() const noexcept
+  {
+    return agentManager;
+  }
+
+  const EnergySources & getEnergySources() const noexcept
+  {
+    return energySources;
+  }
+
+  std::size_t getTicksCount() const noexcept
+  {
+    return ticksCount;
+  }
+
+  ThreadPool & getThreadPool() noexcept
+  {
+    return threadPool;
+  }
+
+  const Tuner & getTuner() const noexcept
+  {
+    return tuner;
+  }
+
+  const sf::Vector2f worldSize;
+  const std::size_t maxAgentsNumber;
+  const std::size_t maxSourcesNumber;
+  const std::size_t threadsNumber;
+  const std::uint64_t seed;
+
+private:
+  // Ways to execute the update in parallel
+  enum class UpdateMode
+  {
+    // System after system, each either serial or parallel as the tuner decides
+    Tuned,
+    // Per-chunk task graph
+    Graph,
+    // A long-lived loop per thread, synchronised by a barrier
+    Team,
+    // Groups of systems executed over cache-sized chunks
+    Fused
+  };
+
+  class Grid
+  {
+  public:
+    struct Cell
+    {
+      std::vector<std::size_t> sources;
+    };
+
+    // Indexes of agents in a cell
+    struct Agents
+    {
+      const std::size_t * first;
+      const std::size_t * last;
+
+      const std::size_t * begin() const noexcept { return first; }
+      const std::size_t * end() const noexcept { return last; }
+    };
+
+    Grid(sf::Vector2f worldSize)
+      : width(static_cast<std::size_t>(std::ceil(worldSize.x / cellSize)) + 2 * offset),
+        height(static_cast<std::size_t>(std::ceil(worldSize.y / cellSize)) + 2 * offset),
+        cells(width, std::vector<Cell>(height)),
+        agentStarts(width * height + 1, 0) { }
+
+    void rebuildAgents(const Manager<AgentSettings> & agentManager, ThreadPool & threadPool);
+
+    void clearSourcesInfo() noexcept
+    {
+      for (auto & line : cells)
+      {
+        for (auto & cell : line)
+        {
+          cell.sources.clear();
+        }
+      }
+    }
+
+    void clear() noexcept
+    {
+      clearSourcesInfo();
+      std::fill(agentStarts.begin(), agentStarts.end(), 0);
+      agentIndexes.clear();
+    }
+
+    std::size_t index(float coordinate) const noexcept
+    {
+      return static_cast<std::size_t>(coordinate) / cellSize;
+    }
+
+    sf::Vector2<std::size_t> worldToGrid(sf::Vector2f position) const noexcept
+    {
+      return { index(position.x), index(position.y) };
+    }
+
+    Cell & cell(sf::Vector2<std::size_t> indexes)
+    {
+      assert(indexes.x < width - offset);
+      assert(indexes.y < height - offset);
+
+      return cells[indexes.x + offset][indexes.y + offset];
+    }
+
+    const Cell & cell(sf::Vector2<std::size_t> indexes) const
+    {
+      assert(indexes.x < width - offset);
+      assert(indexes.y < height - offset);
+
+      return cells[indexes.x + offset][indexes.y + offset];
+    }
+
+    Agents agents(sf::Vector2<std::size_t> indexes) const
+    {
+      const auto cell = flatIndex(indexes);
+
+      return { agentIndexes.data() + agentStarts[cell],
+               agentIndexes.data() + agentStarts[cell + 1] };
+    }
+
+  private:
+    std::size_t flatIndex(sf::Vector2<std::size_t> indexes) const noexcept
+    {
+      assert(indexes.x < width - offset);
+      assert(indexes.y < height - offset);
+
+      return (indexes.x + offset) * height + indexes.y + offset;
+    }
+
+    const std::size_t offset{1};
+    const std::size_t cellSize{150};
+    const std::size_t width;
+    const std::size_t height;
+
+    std::vector<std::vector<Cell>> cells;
+    // Agents of all cells, cell by cell. Agents of cell i are stored from
+    // agentStarts[i] to agentStarts[i + 1]
+    std::vector<std::size_t> agentStarts;
+    std::vector<std::size_t> agentIndexes;
+    // Counts of agents per cell for every block of agents, then positions
+    // where the block puts them
+    std::vector<std::size_t> blockOffsets;
+  };
+
+  void update(float delta);
+
+  template<typename TSignature, typename TFunc>
+  std::vector<ThreadPool::TaskGraph::Node> addUpdatePhase(TFunc func);
+  void buildUpdateGraph();
+  void updateInTeam(float delta);
+  void buildPipeline();
+  void updateFused(float delta);
+  void updateTuned(float delta);
+
+  void moveAgent(std::size_t index, float delta);
+  void updateAgentPositionAndRotation(std::size_t index);
+  void applyAgentMetabolism(std::size_t index, float delta);
+  void indicateAgentEnergyLevel(std::size_t index);
+  void indicateAgentKnowledge(std::size_t index);
+  void lookForEnergy(std::size_t index);
+  void claimEnergySource(std::size_t source, std::size_t index);
+  void resolveHarvest();
+  void resolveHarvest(std::size_t first, std::size_t last);
+  void collectInfo(std::size_t index);
+  void regenerateEnergySources(float delta);
+
+  ArenaVector<std::size_t> findSourcesInRange(sf::Vector2f position, float range,
+                                              Arena & arena) const;
+  ArenaVector<std::size_t> findAgentsInRange(sf::Vector2f position, float range,
+                                             Arena & arena) const;
+
+  void createAgents();
+  void spawnAgents(std::size_t count);
+  void initializeAgent(std::size_t index, std::uint64_t id);
+  void createEnergySources();
+
+  Manager<AgentSettings> agentManager;
+  EnergySources energySources;
+  // Agent that harvests each source this tick, the one with the lowest index
+  // of those that reached it
+  std::vector<std::atomic<std::size_t>> harvestClaims;
+  std::size_t ticksCount{0};
+  std::uint64_t nextAgentId{0};
+  // Knowledge of agents at the start of the tick, what neighbors collect
+  std::vector<std::bitset<Information::size>> knowledge;
+
+  Grid grid;
+
+  ThreadPool threadPool;
+  // Parallel update split into chunks of agents. Built once, run every tick
+  ThreadPool::TaskGraph updateGraph;
+  std::size_t updateAgentsCount{0};
+  float updateDelta{0.f};
+  UpdateMode updateMode{UpdateMode::Tuned};
+  Barrier phaseBarrier;
+  Pipeline<AgentSettings> pipeline;
+  std::size_t harvestingSystem{0};
+  // Amount of components a fused chunk should take, about the size of L2
+  static const std::size_t fusedChunkBytes = 256 * 1024;
+  Tuner tuner;
+  // Per-system costs of agents, to balance parallel executions by cost
+  std::vector<CostModel> costModels;
+  std::vector<std::size_t> partitionBoundaries;
+};
+}
+
+#endif
@@ -1,123 +1,666 @@
 #ifndef ABM_THREAD_POOL_HPP
 #define ABM_THREAD_POOL_HPP
 
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
 #include <mutex>
+#include <condition_variable>
 #include <thread>
 #include <future>
+#include <memory>
+#include <new>
 #include <vector>
-#include <queue>
 #include <functional>
 #include <type_traits>
 #include <cassert>
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#endif
+
+#include "Arena.hpp"
+#include "WorkStealingQueue.hpp"
+#include "MpmcQueue.hpp"
+#include "Latch.hpp"
+#include "Topology.hpp"
 
 namespace ABM
 {
+struct ThreadPoolOptions
+{
+  // How long an idle worker keeps polling the queue before it goes to sleep
+  std::chrono::microseconds spinDuration{200};
+  // Pin every worker to its own CPU, spread evenly over NUMA nodes. Workers
+  // that don't get a CPU of their own stay unpinned
+  bool pinWorkers = false;
+  // Place workers only on the first hardware thread of each core
+  bool skipSmtSiblings = false;
+  // Extra threads that execute only background tasks. Without them
+  // background tasks run on regular workers when they run out of other work
+  std::size_t backgroundThreads = 0;
+  // Collect per-worker statistics. Can be switched at runtime as well
+  bool collectMetrics = false;
+  // Adjust the number of active workers to the parallel efficiency measured
+  // in parallelFor calls and task graph runs
+  bool elastic = false;
+};
+
 class ThreadPool
 {
 private:
+  /**
+   * @brief Type-erased callable. Small callables are stored inline and only
+   * large ones are moved to the heap
+   */
   class Task
   {
   private:
-    struct ImplBase
+    static constexpr std::size_t inlineSize = 48;
+
+    using Storage = std::aligned_storage_t<inlineSize, alignof(std::max_align_t)>;
+
+    struct VTable
     {
-      virtual void call() = 0;
-      virtual ~ImplBase() { }
+      void (*call)(void * storage);
+      // Move-constructs a callable in destination and destroys the source one
+      void (*move)(void * destination, void * source) noexcept;
+      void (*destroy)(void * storage) noexcept;
+    };
+
+    template<typename T>
+    struct InlineImpl
+    {
+      static void call(void * storage)
+      {
+        (*static_cast<T *>(storage))();
+      }
+
+      static void move(void * destination, void * source) noexcept
+      {
+        new (destination) T(std::move(*static_cast<T *>(source)));
+        static_cast<T *>(source)->~T();
+      }
+
+      static void destroy(void * storage) noexcept
+      {
+        static_cast<T *>(storage)->~T();
+      }
+
+      static const VTable * vtable() noexcept
+      {
+        static const VTable table{ & call, & move, & destroy };
+
+        return & table;
+      }
     };
 
     template<typename T>
-    struct Impl : public ImplBase
+    struct HeapImpl
     {
-      T cally;
+      static void call(void * storage)
+      {
+        (**static_cast<T **>(storage))();
+      }
 
-      Impl(T && cally) : cally(std::move(cally)) { }
+      static void move(void * destination, void * source) noexcept
+      {
+        *static_cast<T **>(destination) = *static_cast<T **>(source);
+      }
 
-      void call() override
+      static void destroy(void * storage) noexcept
       {
-        cally();
+        delete *static_cast<T **>(storage);
+      }
+
+      static const VTable * vtable() noexcept
+      {
+        static const VTable table{ & call, & move, & destroy };
+
+        return & table;
       }
     };
 
-    std::unique_ptr<ImplBase> impl;
+    template<typename T>
+    static constexpr bool fitsInline() noexcept
+    {
+      return sizeof(T) <= sizeof(Storage) &&
+             alignof(T) <= alignof(Storage) &&
+             std::is_nothrow_move_constructible<T>::value;
+    }
+
+    template<typename T>
+    void construct(T && cally, std::true_type)
+    {
+      new (& storage) T(std::move(cally));
+      vtable = InlineImpl<T>::vtable();
+    }
+
+    template<typename T>
+    void construct(T && cally, std::false_type)
+    {
+      new (& storage) T *(new T(std::move(cally)));
+      vtable = HeapImpl<T>::vtable();
+    }
+
+    void reset() noexcept
+    {
+      if (vtable != nullptr)
+      {
+        vtable->destroy(& storage);
+        vtable = nullptr;
+      }
+    }
+
+    const VTable * vtable = nullptr;
+    // Time of submission in nanoseconds, used for statistics only.
+    // Occupies space that would otherwise be taken by padding
+    std::uint64_t submitTime = 0;
+    Storage storage;
 
   public:
     Task() = default;
-    Task(Task && task) : impl(std::move(task.impl)) { }
+    Task(Task && task) noexcept : vtable(task.vtable), submitTime(task.submitTime)
+    {
+      if (vtable != nullptr)
+      {
+        vtable->move(& storage, & task.storage);
+        task.vtable = nullptr;
+      }
+    }
     template<typename TFunction>
-    Task(TFunction && func) : impl(new Impl<TFunction>(std::move(func))) { }
-    Task & operator=(Task && task)
+    Task(TFunction && func)
     {
-      impl = std::move(task.impl);
+      using Function = std::decay_t<TFunction>;
+
+      construct<Function>(std::move(func), std::integral_constant<bool, fitsInline<Function>()>());
+    }
+    Task & operator=(Task && task) noexcept
+    {
+      if (this != & task)
+      {
+        reset();
+
+        if (task.vtable != nullptr)
+        {
+          task.vtable->move(& storage, & task.storage);
+          vtable = task.vtable;
+          task.vtable = nullptr;
+        }
+
+        submitTime = task.submitTime;
+      }
 
       return *this;
     }
+    ~Task()
+    {
+      reset();
+    }
 
     Task(const Task &) = delete;
     Task(Task &) = delete;
     Task & operator=(const Task &) = delete;
 
+    std::uint64_t getSubmitTime() const noexcept { return submitTime; }
+    void setSubmitTime(std::uint64_t value) noexcept { submitTime = value; }
+
     void operator()()
     {
-      impl->call();
+      vtable->call(& storage);
     }
   };
 
+  // Statistics of a worker. Written only by the worker itself
+  struct Counters
+  {
+    std::atomic<std::uint64_t> tasksExecuted{0};
+    std::atomic<std::uint64_t> steals{0};
+    std::atomic<std::uint64_t> busyTime{0};
+    std::atomic<std::uint64_t> idleTime{0};
+    std::atomic<std::uint64_t> parkedTime{0};
+    std::atomic<std::uint64_t> queueHighWater{0};
+    std::atomic<std::uint64_t> totalLatency{0};
+    std::atomic<std::uint64_t> maxLatency{0};
+  };
+
+  struct Worker
+  {
+    Worker(std::uint32_t seed, const Topology::Cpu & cpu, bool pinnable)
+      : randomState(seed), cpu(cpu), pinnable(pinnable) { }
+
+    WorkStealingQueue<Task> tasks;
+    std::uint32_t randomState;
+    const Topology::Cpu cpu;
+    // Whether the CPU belongs to this worker alone
+    const bool pinnable;
+
+    // Tasks addressed to this particular worker
+    MpmcQueue<Task> mailbox{256};
+    // Member of a team. Unlike mail, nobody else takes it: team members
+    // block each other, so they must not end up on the same thread. A team
+    // claims the slots of all of its workers at once before it writes the
+    // members, and every worker releases its slot once the member is taken
+    Task teamTask;
+    std::atomic_bool teamTaskClaimed{false};
+    std::atomic_bool teamTaskReady{false};
+    std::atomic_bool parked{false};
+    // Memory for temporaries of the tasks, reset after every task
+    Arena arena;
+
+    Counters counters;
+  };
+
+  // Description of a parallelFor call. Lives on the caller's stack
+  struct RangeJob
+  {
+    using Body = void (*)(void * body, std::size_t first, std::size_t last);
+
+    static constexpr std::size_t maxPartitions = 64;
+
+    // Part of the range that is processed by a preferred thread first
+    struct Partition
+    {
+      std::atomic<std::size_t> next;
+      std::size_t last;
+      char padding[64 - sizeof(std::atomic<std::size_t>) - sizeof(std::size_t)];
+    };
+
+    // Partitions are of equal length unless boundaries are given
+    RangeJob(std::size_t first, std::size_t last, std::size_t grain,
+             std::size_t partitionsCount, std::size_t helpers,
+             Body invoke, void * body, bool timed,
+             const std::size_t * boundaries = nullptr);
+
+    void run(std::size_t partition) noexcept;
+
+    const std::size_t grain;
+    const std::size_t partitionsCount;
+    const std::size_t participants;
+    const Body invoke;
+    void * const body;
+    CountdownLatch latch;
+    // Zero unless the job measures its efficiency
+    const std::uint64_t startTime;
+    std::atomic<std::uint64_t> workTime{0};
+    // Set by the first chunk that throws. The rest of the chunks are skipped
+    std::atomic_bool failed{false};
+    std::exception_ptr exception;
+    std::array<Partition, maxPartitions> partitions;
+  };
+
+  // State of the controller of the active workers count
+  struct Elasticity
+  {
+    // Number of parallel regions averaged before making a decision
+    static constexpr std::size_t window = 16;
+    static constexpr double growThreshold = 0.75;
+    static constexpr double shrinkThreshold = 0.4;
+
+    std::mutex mutex;
+    // Smoothed share of the participants' time spent on actual work
+    double efficiency = 1.0;
+    std::size_t samples = 0;
+  };
+
+  template<typename TBody>
+  static void invokeRange(void * body, std::size_t first, std::size_t last)
+  {
+    (*static_cast<TBody *>(body))(first, last);
+  }
+
+  const ThreadPoolOptions options;
+  const Topology topology;
   std::atomic_bool done{false};
-  std::mutex tasksMutex;
-  std::queue<Task> tasks;
+  std::atomic<std::size_t> parkedWorkers{0};
+  std::mutex parkingMutex;
+  std::condition_variable parkingCondition;
+  // Workers with an index beyond this one don't take shared work
+  std::atomic<std::size_t> activeWorkers;
+  std::condition_variable inactiveCondition;
+  Elasticity elasticity;
+
+  // Tasks submitted from outside of the pool
+  MpmcQueue<Task> tasks;
+
+  std::atomic_bool metricsEnabled;
+  std::atomic<std::size_t> sharedQueueHighWater{0};
+
+  // Tasks that must not delay frame-critical work
+  MpmcQueue<Task> backgroundTasks;
+  std::atomic<std::size_t> parkedBackgroundWorkers{0};
+  std::condition_variable backgroundCondition;
+  std::vector<std::thread> backgroundThreads;
+
+  std::vector<std::unique_ptr<Worker>> workers;
   std::vector<std::thread> threads;
 
-public:
-  explicit ThreadPool(std::size_t threadNumber)
+  void submit(Task && task);
+  void submitBatch(Task * batch, std::size_t count);
+  void submitTo(std::size_t workerIndex, Task && task);
+  void claimTeamWorkers(std::size_t teamSize);
+  bool tryClaimTeamWorkers(std::size_t teamSize);
+  void submitTeamTask(std::size_t workerIndex, Task && task);
+  void pushShared(Task && task);
+  void stamp(Task & task) noexcept;
+  void execute(Task & task, Worker & worker);
+  void submitBackground(Task && task);
+  bool tryPopBackgroundTask(Task & task);
+  bool tryPopTask(Task & task);
+  bool tryPopMail(Task & task, std::size_t workerIndex);
+  bool tryTakeTeamTask(Task & task, Worker & worker);
+  bool tryTakeMail(Task & task, std::size_t thiefIndex);
+  bool tryStealTask(Task & task, std::size_t thiefIndex, std::uint32_t & randomState);
+  bool findTask(Task & task, std::size_t workerIndex, bool takeOthersMail);
+  std::size_t getTeamWorker(std::size_t member) const noexcept;
+  bool hasPendingTasks() const noexcept;
+  void wakeWorkers(std::size_t count);
+  void park(std::size_t workerIndex);
+  void parkInactive(std::size_t workerIndex);
+  void runRangeJob(RangeJob & job, std::size_t helpers, bool affine);
+  static bool isTeamMember() noexcept;
+  void recordRangeJob(const RangeJob & job);
+  void recordParallelRegion(std::uint64_t workTime, std::uint64_t wallTime,
+                            std::size_t participants);
+  void workerLoop(std::size_t workerIndex);
+  void backgroundLoop();
+
+  /**
+   * @brief Marks the calling thread as a member of a team while it exists
+   */
+  class TeamMemberScope
   {
-    assert(threadNumber != 0);
+  public:
+    TeamMemberScope() noexcept;
+    ~TeamMemberScope();
+
+    TeamMemberScope(const TeamMemberScope &) = delete;
+    TeamMemberScope & operator=(const TeamMemberScope &) = delete;
+
+  private:
+    const bool wasTeamMember;
+  };
 
-    for (std::size_t i{0}; i < threadNumber; ++i)
+  /**
+   * @brief Executes pending tasks until a given condition is met instead of
+   * blocking the waiting thread
+   */
+  template<typename TPredicate>
+  void helpUntil(TPredicate && isDone)
+  {
+    while (!isDone())
     {
-      threads.emplace_back([this]
+      if (!runPendingTask())
       {
-        while (!done)
-        {
-          Task task;
-          bool hasTask{false};
+        std::this_thread::yield();
+      }
+    }
+  }
 
-          {
-            std::lock_guard<std::mutex> lock{tasksMutex};
+public:
+  // Snapshot of a worker's statistics
+  struct WorkerMetrics
+  {
+    std::uint64_t tasksExecuted = 0;
+    // Tasks taken from other workers
+    std::uint64_t steals = 0;
+    // Time spent executing tasks
+    std::chrono::nanoseconds busyTime{0};
+    // Time spent polling for tasks
+    std::chrono::nanoseconds idleTime{0};
+    // Time spent sleeping
+    std::chrono::nanoseconds parkedTime{0};
+    // Maximum number of tasks in the worker's deque and mailbox
+    std::size_t queueHighWater = 0;
+    // Time between submission of tasks and start of their execution
+    std::chrono::nanoseconds totalLatency{0};
+    std::chrono::nanoseconds maxLatency{0};
+  };
 
-            if (!tasks.empty())
-            {
-              hasTask = true;
-              task = std::move(tasks.front());
+  struct Metrics
+  {
+    std::vector<WorkerMetrics> workers;
+    // Maximum number of tasks in the shared queue
+    std::size_t sharedQueueHighWater = 0;
+  };
 
-              tasks.pop();
-            }
-          }
+  /**
+   * @brief A set of tasks that can be waited for together.
+   * A waiting thread executes pending tasks of the pool in the meantime,
+   * so tasks can safely spawn and wait for their own subtasks. The first
+   * exception thrown by a task is rethrown by wait()
+   */
+  class TaskGroup
+  {
+  public:
+    explicit TaskGroup(ThreadPool & threadPool) : threadPool(threadPool) { }
+    ~TaskGroup()
+    {
+      // Destructors must not throw, so an exception nobody waited for is lost
+      waitForTasks();
+    }
 
-          if (hasTask)
-          {
-            task();
-          }
-          else
+    TaskGroup(const TaskGroup &) = delete;
+    TaskGroup & operator=(const TaskGroup &) = delete;
+
+    /**
+     * @brief Adds a new task to the group
+     */
+    template<typename TFunction>
+    void run(TFunction && func)
+    {
+      pendingTasks.fetch_add(1, std::memory_order_relaxed);
+
+      threadPool.submit(Task{[this, func = std::forward<TFunction>(func)]() mutable
+      {
+        try
+        {
+          func();
+        }
+        catch (...)
+        {
+          if (!failed.exchange(true, std::memory_order_relaxed))
           {
-            std::this_thread::yield();
+            exception = std::current_exception();
           }
         }
+
+        pendingTasks.fetch_sub(1, std::memory_order_release);
+      }});
+    }
+
+    /**
+     * @brief Waits for all tasks of the group, helping the pool meanwhile.
+     * Rethrows the first exception thrown by a task since the last wait
+     */
+    void wait()
+    {
+      waitForTasks();
+
+      if (failed.load(std::memory_order_relaxed))
+      {
+        auto error = std::move(exception);
+
+        exception = nullptr;
+        failed.store(false, std::memory_order_relaxed);
+        std::rethrow_exception(error);
+      }
+    }
+
+  private:
+    void waitForTasks()
+    {
+      threadPool.helpUntil([this]
+      {
+        return pendingTasks.load(std::memory_order_acquire) == 0;
       });
     }
-  }
 
-  ~ThreadPool()
+    ThreadPool & threadPool;
+    std::atomic<std::size_t> pendingTasks{0};
+    // Set by the first task that throws, read once all tasks are finished
+    std::atomic_bool failed{false};
+    std::exception_ptr exception;
+  };
+
+  /**
+   * @brief A set of tasks with dependencies between them. The graph is built
+   * once and can be run many times. A task is submitted as soon as all of its
+   * predecessors are finished, so independent chains of tasks don't wait for
+   * each other. Nodes have to be added in order of execution: an edge can
+   * only lead to a node added later, which rules out cycles
+   */
+  class TaskGraph
   {
-    done = true;
+  public:
+    using Node = std::size_t;
+
+    explicit TaskGraph(ThreadPool & threadPool) : threadPool(threadPool) { }
+
+    TaskGraph(const TaskGraph &) = delete;
+    TaskGraph & operator=(const TaskGraph &) = delete;
 
-    for (auto & thread : threads)
+    /**
+     * @brief Adds a new task to the graph
+     * @return Identifier of the node, used to connect it to other nodes
+     */
+    template<typename TFunction>
+    Node addNode(TFunction && func)
     {
-      thread.join();
+      nodes.emplace_back(new NodeData{Task{std::forward<TFunction>(func)}});
+
+      return nodes.size() - 1;
     }
+
+    /**
+     * @brief Makes one node wait for another one
+     * @param predecessor - node that has to be finished first
+     * @param successor - node that waits for the predecessor
+     */
+    void addEdge(Node predecessor, Node successor);
+
+    /**
+     * @brief Runs all of the tasks and waits for them, helping the pool
+     * meanwhile. Must not be called while the graph is already running.
+     * Rethrows the first exception thrown by a task
+     */
+    void run();
+
+    std::size_t getNodesCount() const noexcept
+    {
+      return nodes.size();
+    }
+
+  private:
+    struct NodeData
+    {
+      explicit NodeData(Task && work) : work(std::move(work)) { }
+
+      Task work;
+      std::vector<Node> successors;
+      std::size_t dependencies = 0;
+      // Predecessors left to finish during the current run
+      std::atomic<std::size_t> pendingDependencies{0};
+    };
+
+    Task makeTask(Node node);
+    void execute(Node node);
+
+    ThreadPool & threadPool;
+    std::vector<std::unique_ptr<NodeData>> nodes;
+    std::vector<Node> roots;
+    std::atomic<std::size_t> pendingNodes{0};
+    std::atomic_bool failed{false};
+    std::exception_ptr exception;
+    // Time spent in the nodes during the current run, measured only if the
+    // pool is elastic
+    std::atomic<std::uint64_t> workTime{0};
+  };
+
+
+  explicit ThreadPool(std::size_t threadNumber,
+                      ThreadPoolOptions options = ThreadPoolOptions{});
+  ~ThreadPool();
+
+  /**
+   * @brief Executes one pending task on the calling thread
+   * @return False if there was nothing to execute
+   */
+  bool runPendingTask();
+
+  /**
+   * @brief Returns number of worker threads
+   */
+  std::size_t getThreadsCount() const noexcept
+  {
+    return threads.size();
+  }
+
+  /**
+   * @brief Returns scratch arena of the calling thread. Workers have their
+   * own arenas that are reset after every top-level task; other threads get
+   * a thread-local one. Tasks that can be executed while another task is
+   * waiting should release their memory with Arena::Scope
+   */
+  Arena & getScratchArena() noexcept;
+
+  /**
+   * @brief Switches collection of statistics on or off
+   */
+  void setMetricsEnabled(bool value) noexcept
+  {
+    metricsEnabled = value;
+  }
+
+  bool isMetricsEnabled() const noexcept
+  {
+    return metricsEnabled;
+  }
+
+  /**
+   * @brief Returns statistics collected since the start or the last reset.
+   * Counters are read without stopping the workers, so they are only
+   * approximately consistent with each other
+   */
+  Metrics getMetrics() const;
+
+  /**
+   * @brief Resets collected statistics. Should be called when the pool
+   * is idle, otherwise some updates can be lost
+   */
+  void resetMetrics() noexcept;
+
+  /**
+   * @brief Returns number of threads reserved for background tasks
+   */
+  std::size_t getBackgroundThreadsCount() const noexcept
+  {
+    return backgroundThreads.size();
+  }
+
+  /**
+   * @brief Returns topology of the machine the pool runs on
+   */
+  const Topology & getTopology() const noexcept
+  {
+    return topology;
+  }
+
+  /**
+   * @brief Returns CPU that a worker is placed on. Workers with adjacent
+   * indexes share a NUMA node, so data can be partitioned accordingly
+   */
+  const Topology::Cpu & getWorkerCpu(std::size_t workerIndex) const noexcept
+  {
+    return workers[workerIndex]->cpu;
   }
 
   /**
-   * @brief Adds a new task to the queue
+   * @brief Adds a new task to the queue. Tasks submitted from a worker
+   * thread go to that worker's own deque
    */
   template<typename TFunction, typename... TArgs>
   auto addTask(TFunction && func, TArgs && ... args)
@@ -126,16 +669,283 @@ public:
 
     auto bindedFunc = std::bind(std::forward<TFunction>(func),
                                std::forward<TArgs>(args)...);
-    std::packaged_task<ReturnType()> newTask{bindedFunc};
+    std::packaged_task<ReturnType()> newTask{std::move(bindedFunc)};
     auto future = newTask.get_future();
 
+    submit(std::move(newTask));
+
+    return future;
+  }
+
+  /**
+   * @brief Adds a new background task. Background tasks are executed only
+   * when there are no other pending tasks and waiting threads never pick
+   * them up, so they can't delay frame-critical work
+   */
+  template<typename TFunction, typename... TArgs>
+  auto addBackgroundTask(TFunction && func, TArgs && ... args)
+  {
+    using ReturnType = typename std::result_of<TFunction(TArgs...)>::type;
+
+    auto bindedFunc = std::bind(std::forward<TFunction>(func),
+                               std::forward<TArgs>(args)...);
+    std::packaged_task<ReturnType()> newTask{std::move(bindedFunc)};
+    auto future = newTask.get_future();
+
+    submitBackground(std::move(newTask));
+
+    return future;
+  }
+
+#if defined(__cpp_impl_coroutine)
+  /**
+   * @brief Awaitable that suspends a coroutine and resumes it on the pool
+   */
+  class ScheduleAwaiter
+  {
+  public:
+    ScheduleAwaiter(ThreadPool & threadPool, bool background) noexcept
+      : threadPool(threadPool), background(background) { }
+
+    bool await_ready() const noexcept
     {
-      std::lock_guard<std::mutex> lock{tasksMutex};
+      return false;
+    }
 
-      tasks.push(std::move(newTask));
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+      Task task{[handle] { handle.resume(); }};
+
+      if (background)
+      {
+        threadPool.submitBackground(std::move(task));
+      }
+      else
+      {
+        threadPool.submit(std::move(task));
+      }
     }
 
-    return future;
+    void await_resume() const noexcept { }
+
+  private:
+    ThreadPool & threadPool;
+    const bool background;
+  };
+
+  /**
+   * @brief Continues a coroutine on one of the workers:
+   * co_await threadPool.schedule();
+   */
+  ScheduleAwaiter schedule() noexcept
+  {
+    return ScheduleAwaiter{*this, false};
+  }
+
+  /**
+   * @brief Continues a coroutine as a background task
+   */
+  ScheduleAwaiter scheduleBackground() noexcept
+  {
+    return ScheduleAwaiter{*this, true};
+  }
+#endif
+
+  /**
+   * @brief Adds a range of tasks at once. Tasks submitted from outside of
+   * the pool are published to the shared queue in batches. Results of the
+   * tasks are discarded, use TaskGroup to wait for them
+   */
+  template<typename TIterator>
+  void addTasks(TIterator first, TIterator last)
+  {
+    std::array<Task, 64> batch;
+    std::size_t count = 0;
+
+    for ( ; first != last; ++first)
+    {
+      batch[count++] = Task{std::move(*first)};
+
+      if (count == batch.size())
+      {
+        submitBatch(batch.data(), count);
+        count = 0;
+      }
+    }
+
+    submitBatch(batch.data(), count);
+  }
+
+  // How parallelFor distributes chunks of a range
+  enum class Schedule
+  {
+    // Any thread takes the next chunk
+    Dynamic,
+    // The range is split into partitions with a fixed preferred worker
+    // each. The same range is always handed out the same way, so the data
+    // stays in that worker's caches across calls. Chunks of other
+    // partitions are taken only once a thread runs out of its own
+    Affine
+  };
+
+  /**
+   * @brief Splits [first, last) into chunks of a given size and executes
+   * body(chunkFirst, chunkLast) for each of them on the workers and on the
+   * calling thread. Returns when all chunks are processed, executing other
+   * pending tasks while waiting, so calls can be nested. If the body throws,
+   * the remaining chunks are skipped and the first exception is rethrown.
+   * Nothing is allocated per chunk: the range descriptor lives on the
+   * caller's stack and workers pick chunks from it through atomic cursors
+   */
+  template<typename TBody>
+  void parallelFor(std::size_t first, std::size_t last, std::size_t grain,
+                   TBody && body, Schedule schedule = Schedule::Dynamic)
+  {
+    using Body = std::remove_reference_t<TBody>;
+
+    if (first >= last)
+    {
+      return;
+    }
+
+    grain = std::max<std::size_t>(grain, 1);
+
+    const auto chunks = (last - first + grain - 1) / grain;
+
+    if (chunks == 1)
+    {
+      body(first, last);
+
+      return;
+    }
+
+    const auto helpers = std::min({ getActiveWorkersCount(), chunks - 1,
+                                    RangeJob::maxPartitions - 1 });
+    // The calling thread owns the last partition
+    const auto partitionsCount = schedule == Schedule::Affine ? helpers + 1 : 1;
+    RangeJob job{first, last, grain, partitionsCount, helpers, & invokeRange<Body>,
+                 const_cast<void *>(static_cast<const void *>(std::addressof(body))),
+                 options.elastic};
+
+    runRangeJob(job, helpers, schedule == Schedule::Affine);
+  }
+
+  static constexpr std::size_t getMaxPartitionsCount() noexcept
+  {
+    return RangeJob::maxPartitions;
+  }
+
+  /**
+   * @brief Same as affine parallelFor, but partition i is
+   * [boundaries[i], boundaries[i + 1]) instead of an equal share of the
+   * range, so partitions can be made of equal cost rather than of equal
+   * length when elements cost differently. Threads still take chunks of
+   * other partitions once they run out of their own
+   */
+  template<typename TBody>
+  void parallelFor(const std::vector<std::size_t> & boundaries, std::size_t grain,
+                   TBody && body)
+  {
+    using Body = std::remove_reference_t<TBody>;
+
+    assert(boundaries.size() >= 2 && boundaries.size() - 1 <= RangeJob::maxPartitions);
+
+    const auto first = boundaries.front();
+    const auto last = boundaries.back();
+
+    if (first >= last)
+    {
+      return;
+    }
+
+    grain = std::max<std::size_t>(grain, 1);
+
+    const auto partitionsCount = boundaries.size() - 1;
+    const auto helpers = std::min(getActiveWorkersCount(), partitionsCount - 1);
+    RangeJob job{first, last, grain, partitionsCount, helpers, & invokeRange<Body>,
+                 const_cast<void *>(static_cast<const void *>(std::addressof(body))),
+                 options.elastic, boundaries.data()};
+
+    runRangeJob(job, helpers, true);
+  }
+
+  /**
+   * @brief Sets how many workers take shared work. The rest finish the
+   * tasks addressed to them and park. Adjusted automatically if the pool is
+   * elastic
+   */
+  void setActiveWorkersCount(std::size_t count);
+
+  std::size_t getActiveWorkersCount() const noexcept
+  {
+    return activeWorkers.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Returns the biggest team runTeam() can start from the calling
+   * thread: every worker plus the caller itself if it's not a worker
+   */
+  std::size_t getMaxTeamSize() const noexcept;
+
+  /**
+   * @brief Executes func(memberIndex) on teamSize threads at the same time,
+   * the calling thread being member 0. Unlike regular tasks, every member is
+   * handed to its own worker, which is woken up for it and is the only one
+   * that can take it, so members can synchronise with each other through a
+   * Barrier. A worker that is busy takes its member once it finishes the
+   * current task or starts waiting. Returns when all members are finished.
+   * The first exception thrown by a member is rethrown then. Other members
+   * still have to finish by themselves, so a member must not throw while
+   * the rest can wait for it in a Barrier. Members must not start teams or
+   * parallel loops either: threads they would wait for can be blocked in a
+   * Barrier that does not help the pool
+   */
+  template<typename TFunction>
+  void runTeam(std::size_t teamSize, TFunction && func)
+  {
+    assert(teamSize != 0 && teamSize <= getMaxTeamSize());
+    assert(!isTeamMember());
+
+    CountdownLatch latch{teamSize - 1};
+    std::atomic_bool failed{false};
+    std::exception_ptr exception;
+    // Members refer to the caller's stack, so they must count down even if
+    // they throw
+    const auto runMember = [& func, & failed, & exception](std::size_t member) noexcept
+    {
+      const TeamMemberScope scope;
+
+      try
+      {
+        func(member);
+      }
+      catch (...)
+      {
+        if (!failed.exchange(true, std::memory_order_relaxed))
+        {
+          exception = std::current_exception();
+        }
+      }
+    };
+
+    claimTeamWorkers(teamSize);
+
+    for (std::size_t member = 1; member < teamSize; ++member)
+    {
+      submitTeamTask(getTeamWorker(member), Task{[& runMember, & latch, member]
+      {
+        runMember(member);
+        latch.countDown();
+      }});
+    }
+
+    runMember(0);
+    helpUntil([& latch] { return latch.isReady(); });
+
+    if (failed.load(std::memory_order_relaxed))
+    {
+      std::rethrow_exception(exception);
+    }
   }
 };
 }
@@ -0,0 +1,70 @@
+#ifndef ABM_TOPOLOGY_HPP
+#define ABM_TOPOLOGY_HPP
+
+#include <string>
+#include <vector>
+
+namespace ABM
+{
+/**
+ * @brief Layout of logical CPUs: which core, package and NUMA node each of
+ * them belongs to
+ */
+class Topology
+{
+public:
+  struct Cpu
+  {
+    std::size_t id = 0;
+    std::size_t core = 0;
+    std::size_t package = 0;
+    std::size_t node = 0;
+    // False for the second and further SMT siblings of a core
+    bool primaryThread = true;
+  };
+
+  /**
+   * @brief Reads topology from sysfs. Falls back to a flat layout of
+   * std::thread::hardware_concurrency() CPUs if it's not available
+   */
+  static Topology detect(const std::string & root = "/sys/devices/system/cpu");
+
+  /**
+   * @brief Parses kernel's CPU list format, e.g. "0-3,8,10-11"
+   */
+  static std::vector<std::size_t> parseCpuList(const std::string & list);
+
+  /**
+   * @brief Returns CPUs the calling thread is allowed to run on
+   * @return Empty vector if the affinity mask is not available
+   */
+  static std::vector<std::size_t> getAllowedCpus();
+
+  /**
+   * @brief Pins the calling thread to a given logical CPU
+   * @return False if pinning is not supported or failed
+   */
+  static bool pinCurrentThread(std::size_t cpu) noexcept;
+
+  /**
+   * @brief Chooses distinct CPUs for a given number of threads. Primary
+   * threads of cores are taken before SMT siblings, from all NUMA nodes in
+   * turn, so threads are spread evenly over the nodes. The result is ordered
+   * by node, so neighbouring threads share a node and caches as much as
+   * possible. Contains fewer CPUs than threads if there are not enough of
+   * them, a CPU is never used twice
+   * @param allowedCpus - CPUs that can be used, all of them if empty
+   */
+  std::vector<Cpu> selectCpus(std::size_t count, bool skipSmtSiblings,
+                              const std::vector<std::size_t> & allowedCpus) const;
+
+  const std::vector<Cpu> & getCpus() const noexcept { return cpus; }
+  std::size_t getNodesCount() const noexcept { return nodesCount; }
+
+private:
+  std::vector<Cpu> cpus;
+  std::size_t nodesCount = 1;
+};
+}
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef ABM_TUNER_HPP
+#define ABM_TUNER_HPP
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace ABM
+{
+/**
+ * @brief Chooses between serial and parallel execution of systems and the
+ * grain of parallel execution. Per-agent cost of every system is measured
+ * from its serial executions and overhead of going parallel from its
+ * parallel ones. Decisions are cached and every once in a while the other
+ * option is tried again, so they follow changes of population and load
+ */
+class Tuner
+{
+public:
+  struct Decision
+  {
+    bool parallel = false;
+    // Number of agents per chunk of a parallel execution
+    std::size_t grain = 0;
+  };
+
+  /**
+   * @brief C-tor
+   * @param reevaluationPeriod - number of executions of a system after which
+   * the option that is not chosen is tried again
+   * @param chunkDuration - desired duration of a chunk of a parallel execution
+   */
+  explicit Tuner(std::size_t reevaluationPeriod = 256,
+                 std::chrono::nanoseconds chunkDuration = std::chrono::microseconds{20});
+
+  /**
+   * @brief Registers a system
+   * @return Index of the system
+   */
+  std::size_t addSystem(const std::string & name);
+
+  /**
+   * @brief Chooses how to execute a system
+   * @param agentsCount - number of agents to process
+   * @param participants - number of threads a parallel execution would use
+   */
+  Decision decide(std::size_t system, std::size_t agentsCount, std::size_t participants);
+
+  /**
+   * @brief Reports duration of an execution made according to a decision
+   */
+  void record(std::size_t system, const Decision & decision, std::size_t agentsCount,
+              std::chrono::nanoseconds duration);
+
+  /**
+   * @brief Returns current decisions and measurements, one line per system
+   */
+  std::string getReport() const;
+
+private:
+  struct Entry
+  {
+    std::string name;
+    // Smoothed serial execution time per agent, in nanoseconds
+    double agentCost = 0;
+    // Smoothed extra time of a parallel execution, in nanoseconds
+    double parallelOverhead = 0;
+    bool serialMeasured = false;
+    bool parallelMeasured = false;
+    Decision decision;
+    std::size_t participants = 1;
+    std::size_t executions = 0;
+  };
+
+  std::size_t calculateGrain(const Entry & entry, std::size_t agentsCount) const;
+
+  const std::size_t reevaluationPeriod;
+  const std::chrono::nanoseconds chunkDuration;
+  std::vector<Entry> entries;
+};
+}
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef ABM_WORK_STEALING_QUEUE_HPP
+#define ABM_WORK_STEALING_QUEUE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <cassert>
+
+namespace ABM
+{
+/**
+ * @brief Bounded Chase-Lev deque.
+ * The owner thread pushes and pops at the bottom (LIFO) while any other
+ * thread may steal from the top (FIFO). A thief claims an element by moving
+ * the top index first and only then moves the element out, so move-only,
+ * non-trivial types can be stored by value
+ */
+template<typename T>
+class WorkStealingQueue
+{
+public:
+  explicit WorkStealingQueue(std::size_t capacity = 1024)
+    : capacity(capacity), mask(capacity - 1), slots(new Slot[capacity])
+  {
+    assert(capacity != 0 && (capacity & mask) == 0);
+  }
+
+  WorkStealingQueue(const WorkStealingQueue &) = delete;
+  WorkStealingQueue & operator=(const WorkStealingQueue &) = delete;
+
+  /**
+   * @brief Pushes an element to the bottom. Owner thread only
+   * @return False if the queue is full
+   */
+  bool push(T && value)
+  {
+    const auto b = bottom.load(std::memory_order_relaxed);
+    const auto t = top.load(std::memory_order_acquire);
+
+    if (b - t >= static_cast<std::int64_t>(capacity))
+    {
+      return false;
+    }
+
+    auto & slot = slots[static_cast<std::size_t>(b) & mask];
+
+    // A thief may still be moving out an element that used to live here
+    while (slot.occupied.load(std::memory_order_acquire))
+    {
+      std::this_thread::yield();
+    }
+
+    slot.value = std::move(value);
+    slot.occupied.store(true, std::memory_order_relaxed);
+    bottom.store(b + 1);
+
+    return true;
+  }
+
+  /**
+   * @brief Pops the most recently pushed element. Owner thread only
+   */
+  bool pop(T & value)
+  {
+    const auto b = bottom.load(std::memory_order_relaxed) - 1;
+
+    bottom.store(b);
+
+    auto t = top.load();
+
+    if (t > b)
+    {
+      bottom.store(b + 1);
+
+      return false;
+    }
+
+    if (t == b)
+    {
+      // The last element, race against thieves for it
+      const auto won = top.compare_exchange_strong(t, t + 1);
+
+      bottom.store(b + 1);
+
+      if (!won)
+      {
+        return false;
+      }
+    }
+
+    take(b, value);
+
+    return true;
+  }
+
+  /**
+   * @brief Steals the oldest element. Can be called from any thread
+   */
+  bool steal(T & value)
+  {
+    auto t = top.load();
+    const auto b = bottom.load();
+
+    if (t >= b || !top.compare_exchange_strong(t, t + 1))
+    {
+      return false;
+    }
+
+    take(t, value);
+
+    return true;
+  }
+
+  /**
+   * @brief Returns approximate number of elements
+   */
+  std::size_t size() const noexcept
+  {
+    const auto b = bottom.load();
+    const auto t = top.load();
+
+    return b > t ? static_cast<std::size_t>(b - t) : 0;
+  }
+
+  bool empty() const noexcept
+  {
+    return size() == 0;
+  }
+
+private:
+  struct Slot
+  {
+    T value;
+    std::atomic_bool occupied{false};
+  };
+
+  void take(std::int64_t index, T & value)
+  {
+    auto & slot = slots[static_cast<std::size_t>(index) & mask];
+
+    value = std::move(slot.value);
+    slot.occupied.store(false, std::memory_order_release);
+  }
+
+  const std::size_t capacity;
+  const std::size_t mask;
+  std::unique_ptr<Slot[]> slots;
+
+  // Keep indexes on separate cache lines so thieves don't disturb the owner
+  char topPadding[64];
+  std::atomic<std::int64_t> top{0};
+  char bottomPadding[64 - sizeof(std::atomic<std::int64_t>)];
+  std::atomic<std::int64_t> bottom{0};
+};
+}
+
+#endif
@@ -0,0 +1,50 @@
+#include <algorithm>
+
+#include "Arena.hpp"
+
+namespace ABM
+{
+/**
+ * @brief Moves to the next block that is big enough, allocating a new one
+ * if there is no such block yet
+ */
+void * Arena::allocateInNextBlock(std::size_t size, std::size_t alignment)
+{
+  const auto required = size + alignment - 1;
+  auto next = currentBlock < blocks.size() ? currentBlock + 1 : 0;
+
+  // Blocks that are too small for this allocation are skipped and stay
+  // unused until the next rewind
+  while (next < blocks.size() && blocks[next].size < required)
+  {
+    ++next;
+  }
+
+  if (next == blocks.size())
+  {
+    const auto newSize = std::max(blockSize, required);
+
+    blocks.push_back({ std::unique_ptr<char[]>(new char[newSize]), newSize });
+  }
+
+  currentBlock = next;
+  offset = 0;
+
+  return allocate(size, alignment);
+}
+
+/**
+ * @brief Returns number of bytes taken from the heap
+ */
+std::size_t Arena::getCapacity() const noexcept
+{
+  std::size_t capacity = 0;
+
+  for (const auto & block : blocks)
+  {
+    capacity += block.size;
+  }
+
+  return capacity;
+}
+}
@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <cassert>
+
+#include "CostModel.hpp"
+
+namespace ABM
+{
+namespace
+{
+// Weight of a new measurement in smoothed costs
+const double smoothing = 0.25;
+}
+
+/**
+ * @brief C-tor
+ * @param blockSize - number of elements that share an estimate
+ */
+CostModel::CostModel(std::size_t blockSize)
+  : blockSize(std::max<std::size_t>(blockSize, 1))
+{
+}
+
+/**
+ * @brief Adapts the model to a new number of elements
+ * @param count - number of elements
+ */
+void CostModel::resize(std::size_t count)
+{
+  blocks.resize((count + blockSize - 1) / blockSize);
+  elementsCount = count;
+}
+
+/**
+ * @brief Sets weight of a block. The measured cost is scaled along with
+ * the weight, so it doesn't lag behind elements that moved, and is dropped
+ * if the block was or becomes empty
+ */
+void CostModel::setWeight(std::size_t block, double weight) noexcept
+{
+  auto & data = blocks[block];
+
+  if (data.cost >= 0 && weight != data.weight)
+  {
+    data.cost = data.weight > 0 && weight > 0 ? data.cost * weight / data.weight : -1;
+  }
+
+  data.weight = weight;
+}
+
+/**
+ * @brief Reports duration of processing [first, last). It's distributed
+ * among covered blocks in proportion to their weights
+ */
+void CostModel::record(std::size_t first, std::size_t last,
+                       std::chrono::nanoseconds duration) noexcept
+{
+  last = std::min(last, elementsCount);
+
+  if (first >= last)
+  {
+    return;
+  }
+
+  const auto firstBlock = first / blockSize;
+  const auto lastBlock = (last + blockSize - 1) / blockSize;
+  const auto time = static_cast<double>(duration.count());
+  double totalWeight = 0;
+
+  for (auto i = firstBlock; i < lastBlock; ++i)
+  {
+    totalWeight += blocks[i].weight;
+  }
+
+  for (auto i = firstBlock; i < lastBlock; ++i)
+  {
+    auto & block = blocks[i];
+    const auto share = totalWeight > 0 ? block.weight / totalWeight :
+                                         1. / (lastBlock - firstBlock);
+    const auto measurement = time * share;
+
+    block.cost = block.cost < 0 ? measurement :
+                                  block.cost + (measurement - block.cost) * smoothing;
+  }
+}
+
+/**
+ * @brief Splits [first, last) into partitions of about equal estimated
+ * cost. Blocks that were not measured yet are estimated from their weight
+ * and the average cost of a unit of weight in measured ones
+ */
+void CostModel::split(std::size_t first, std::size_t last, std::size_t partsCount,
+                      std::vector<std::size_t> & boundaries) const
+{
+  assert(partsCount != 0);
+
+  last = std::min(last, elementsCount);
+  first = std::min(first, last);
+
+  const auto firstBlock = first / blockSize;
+  const auto lastBlock = (last + blockSize - 1) / blockSize;
+  double measuredCost = 0;
+  double measuredWeight = 0;
+
+  for (auto i = firstBlock; i < lastBlock; ++i)
+  {
+    if (blocks[i].cost >= 0)
+    {
+      measuredCost += blocks[i].cost;
+      measuredWeight += blocks[i].weight;
+    }
+  }
+
+  const auto unitCost = measuredWeight > 0 ? measuredCost / measuredWeight : 1.;
+  const auto estimate = [this, unitCost](std::size_t block)
+  {
+    return blocks[block].cost >= 0 ? blocks[block].cost : blocks[block].weight * unitCost;
+  };
+
+  double totalCost = 0;
+
+  for (auto i = firstBlock; i < lastBlock; ++i)
+  {
+    totalCost += estimate(i);
+  }
+
+  boundaries.clear();
+  boundaries.push_back(first);
+
+  double accumulated = 0;
+  auto block = firstBlock;
+
+  for (std::size_t part = 1; part < partsCount; ++part)
+  {
+    const auto target = totalCost * part / partsCount;
+
+    while (block < lastBlock && accumulated + estimate(block) / 2 < target)
+    {
+      accumulated += estimate(block);
+      ++block;
+    }
+
+    boundaries.push_back(std::min(std::max(block * blockSize, first), last));
+  }
+
+  boundaries.push_back(last);
+}
+}
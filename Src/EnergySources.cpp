@@ -0,0 +1,96 @@
+#include "EnergySources.hpp"
+
+namespace ABM
+{
+
+/**
+ * @brief Changes the number of sources. New sources are empty and have
+ * to be set before they are used
+ * @param count - number of sources
+ */
+void EnergySources::resize(std::size_t count)
+{
+  levels.resize(count, 0.f);
+  capacities.resize(count, 0.f);
+  rates.resize(count, 0.f);
+  xs.resize(count, 0.f);
+  ys.resize(count, 0.f);
+}
+
+/**
+ * @brief Sets all properties of a source. Different sources can be set
+ * from different threads
+ * @param index - index of the source
+ * @param maxCapacity
+ * @param currentLevel
+ * @param regenerationRate
+ * @param position
+ */
+void EnergySources::set(std::size_t index, float maxCapacity, float currentLevel,
+                        float regenerationRate, sf::Vector2f position)
+{
+  assert(index < size());
+  assert(maxCapacity > 0);
+  assert(currentLevel <= maxCapacity);
+  assert(regenerationRate > 0);
+
+  levels[index] = currentLevel;
+  capacities[index] = maxCapacity;
+  rates[index] = regenerationRate;
+  xs[index] = position.x;
+  ys[index] = position.y;
+}
+
+/**
+ * @brief Sets current level of energy of a source
+ * @param index - index of the source
+ * @param value
+ */
+void EnergySources::setCurrentLevel(std::size_t index, float value)
+{
+  assert(index < size());
+  assert(value >= 0);
+  assert(value <= capacities[index]);
+
+  levels[index] = value;
+}
+
+/**
+ * @brief Accumulates energy in a range of sources
+ * @param first - index of the first source
+ * @param last - index past the last source
+ * @param delta - time delta
+ */
+void EnergySources::regenerate(std::size_t first, std::size_t last, float delta) noexcept
+{
+  assert(first <= last && last <= size());
+
+  // Raw columns and a minimum without branches let the compiler turn the
+  // loop into SIMD instructions
+  const auto level = levels.data();
+  const auto capacity = capacities.data();
+  const auto rate = rates.data();
+
+  for (auto i = first; i < last; ++i)
+  {
+    const auto value = level[i] + rate[i] * delta;
+
+    level[i] = value < capacity[i] ? value : capacity[i];
+  }
+}
+
+/**
+ * @brief Resets current level of energy of a source to zero
+ * @param index - index of the source
+ * @return Level of energy before reset
+ */
+float EnergySources::reset(std::size_t index)
+{
+  const auto energy = getCurrentLevel(index);
+
+  setCurrentLevel(index, 0);
+
+  return energy;
+}
+
+}
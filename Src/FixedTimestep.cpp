@@ -0,0 +1,74 @@
+#include <algorithm>
+#include <cmath>
+
+#include "FixedTimestep.hpp"
+
+namespace ABM
+{
+namespace
+{
+// Shortest tick that is accepted, in seconds
+const float minTickDuration = 1e-4f;
+}
+
+/**
+ * @brief C-tor
+ * @param tickDuration - simulated time of a tick, in seconds
+ * @param maxSubSteps - maximum number of ticks per frame
+ */
+FixedTimestep::FixedTimestep(float tickDuration, std::size_t maxSubSteps)
+  : tickDuration(std::max(tickDuration, minTickDuration)),
+    maxSubSteps(std::max<std::size_t>(maxSubSteps, 1))
+{
+}
+
+/**
+ * @brief Accounts for real time elapsed since the previous call
+ * @return Number of ticks to simulate now
+ */
+std::size_t FixedTimestep::advance(float elapsed) noexcept
+{
+  if (paused)
+  {
+    return 0;
+  }
+
+  accumulator += std::max(elapsed, 0.f);
+
+  auto ticks = static_cast<std::size_t>(accumulator / tickDuration);
+
+  if (ticks > maxSubSteps)
+  {
+    // Drop the time that can't be caught up with
+    ticks = maxSubSteps;
+    accumulator = std::fmod(accumulator, tickDuration);
+  }
+  else
+  {
+    accumulator -= ticks * tickDuration;
+  }
+
+  // Guard against rounding errors
+  accumulator = std::min(std::max(accumulator, 0.f), tickDuration);
+
+  if (accumulator == tickDuration)
+  {
+    accumulator = 0;
+  }
+
+  return ticks;
+}
+
+void FixedTimestep::setTickDuration(float duration) noexcept
+{
+  const auto interpolation = getInterpolation();
+
+  tickDuration = std::max(duration, minTickDuration);
+  accumulator = interpolation * tickDuration;
+}
+
+void FixedTimestep::setMaxSubSteps(std::size_t count) noexcept
+{
+  maxSubSteps = std::max<std::size_t>(count, 1);
+}
+}
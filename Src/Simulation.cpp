@@ -0,0 +1,1102 @@
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <random>
+
+#include "Simulation.hpp"
+#include "Utils.hpp"
+
+namespace ABM
+{
+namespace
+{
+/**
+ * @brief Options of the thread pool used for the update
+ */
+ThreadPoolOptions makeThreadPoolOptions(const SimulationOptions & simulationOptions)
+{
+  ThreadPoolOptions options;
+
+  options.elastic = simulationOptions.elastic;
+
+  return options;
+}
+
+/**
+ * @brief Returns a given number of threads or, if it's zero, the number of
+ * hardware threads
+ */
+std::size_t getThreadsNumber(std::size_t requested)
+{
+  if (requested != 0)
+  {
+    return requested;
+  }
+
+  return std::thread::hardware_concurrency() != 0 ? std::thread::hardware_concurrency() : 2;
+}
+
+/**
+ * @brief Returns a given seed or a random one if it's not set
+ */
+std::uint64_t getSeed(const SimulationOptions & options)
+{
+  if (options.seeded)
+  {
+    return options.seed;
+  }
+
+  std::random_device randomDevice;
+
+  return (std::uint64_t{randomDevice()} << 32) | randomDevice();
+}
+
+// Number of agents or energy sources generated by a single task
+const std::size_t creationGrain = 1024;
+// Minimum number of agents per block when the grid is rebuilt
+const std::size_t gridBlockSize = 1024;
+// Number of cells processed by a single task when the grid is rebuilt
+const std::size_t gridCellsGrain = 4096;
+// Number of agents whose knowledge is copied by a single task
+const std::size_t knowledgeGrain = 4096;
+// Number of blocks of a cost model weighed by a single task
+const std::size_t weightBlocksGrain = 64;
+// Number of energy sources resolved by a single task
+const std::size_t harvestGrain = 1024;
+// Number of energy sources regenerated by a single task
+const std::size_t regenerationGrain = 16384;
+// Claim of a source that nobody harvests
+const std::size_t noClaim = std::numeric_limits<std::size_t>::max();
+}
+
+/**
+ * @brief C-tor. Builds the world: energy sources and the initial agents are
+ * created right away, other agents are spawned during ticks
+ */
+Simulation::Simulation(const SimulationOptions & options)
+  : worldSize(options.worldSize),
+    maxAgentsNumber(options.maxAgentsNumber),
+    maxSourcesNumber(options.maxSourcesNumber),
+    threadsNumber(getThreadsNumber(options.threadsNumber)),
+    seed(getSeed(options)),
+    grid(worldSize),
+    threadPool(threadsNumber, makeThreadPoolOptions(options)),
+    updateGraph(threadPool),
+    phaseBarrier(threadsNumber),
+    pipeline(agentManager)
+{
+  buildUpdateGraph();
+  buildPipeline();
+  createEnergySources();
+  spawnAgents(std::min(options.initialAgentsNumber, maxAgentsNumber));
+  agentManager.refresh();
+}
+
+/**
+ * @brief Advances the world by one tick
+ * @param delta - simulated time of the tick, in seconds
+ */
+void Simulation::tick(float delta)
+{
+  createAgents();
+  update(delta);
+  agentManager.refresh();
+  ++ticksCount;
+}
+
+/**
+ * @brief Switches to the next way of executing the update in parallel
+ */
+void Simulation::switchUpdateMode()
+{
+  updateMode = updateMode == UpdateMode::Tuned ? UpdateMode::Graph :
+               updateMode == UpdateMode::Graph ? UpdateMode::Team :
+               updateMode == UpdateMode::Team ? UpdateMode::Fused : UpdateMode::Tuned;
+}
+
+/**
+ * @brief Returns name of the current way of executing the update
+ */
+std::string Simulation::getUpdateModeName() const
+{
+  switch (updateMode)
+  {
+  case UpdateMode::Tuned:
+    return "tuned";
+
+  case UpdateMode::Graph:
+    return "graph";
+
+  case UpdateMode::Team:
+    return "team";
+
+  case UpdateMode::Fused:
+    break;
+  }
+
+  return "fused";
+}
+
+/**
+ * @brief Adds a phase of the update to the graph. Every node of the phase
+ * executes a given functor for one chunk of agents that match a specific
+ * Signature
+ * @return Nodes of the phase, one per chunk
+ */
+template<typename TSignature, typename TFunc>
+std::vector<ThreadPool::TaskGraph::Node> Simulation::addUpdatePhase(TFunc func)
+{
+  const auto chunksCount = threadsNumber * 2;
+  std::vector<ThreadPool::TaskGraph::Node> nodes;
+
+  for (std::size_t chunk = 0; chunk < chunksCount; ++chunk)
+  {
+    nodes.push_back(updateGraph.addNode([this, func, chunk, chunksCount]
+    {
+      const auto first = updateAgentsCount * chunk / chunksCount;
+      const auto last = updateAgentsCount * (chunk + 1) / chunksCount;
+
+      agentManager.forGroupMatching<TSignature>(first, last, func);
+    }));
+  }
+
+  return nodes;
+}
+
+/**
+ * @brief Builds the graph of the parallel update. A chunk of agents goes to
+ * the next phase as soon as the data it needs is ready, without waiting for
+ * the other chunks
+ */
+void Simulation::buildUpdateGraph()
+{
+  // Move around the world and look for energy to consume
+  const auto harvest = addUpdatePhase<Harvesting>([this](std::size_t index)
+  {
+    lookForEnergy(index);
+  });
+  // Collect information from neighbors
+  const auto info = addUpdatePhase<InfoCollection>([this](std::size_t index)
+  {
+    collectInfo(index);
+  });
+  // Neighbors can be in any chunk, so nobody moves until everyone has
+  // collected information
+  const auto infoCollected = updateGraph.addNode([] { });
+  // Agents of any chunk can claim the same source, so energy is handed out
+  // once all of them have made their claims
+  const auto harvestResolved = updateGraph.addNode([this] { resolveHarvest(); });
+  // Energy sources are not used by the rest of the phases, so they can
+  // regenerate right after harvesting
+  const auto sourcesUpdate = updateGraph.addNode([this]
+  {
+    regenerateEnergySources(updateDelta);
+  });
+  // Move agents
+  const auto movement = addUpdatePhase<Movement>([this](std::size_t index)
+  {
+    moveAgent(index, updateDelta);
+  });
+  // Rotate an Agent to a direction that it's moving towards
+  const auto render = addUpdatePhase<Render>([this](std::size_t index)
+  {
+    updateAgentPositionAndRotation(index);
+  });
+  // Reduce agent's level of energy as a cost of its action
+  const auto life = addUpdatePhase<Life>([this](std::size_t index)
+  {
+    applyAgentMetabolism(index, updateDelta);
+  });
+  // Change agent's fill color according to its knowledge
+  const auto indication = addUpdatePhase<InfoIndication>([this](std::size_t index)
+  {
+    indicateAgentKnowledge(index);
+  });
+
+  for (std::size_t chunk = 0; chunk < harvest.size(); ++chunk)
+  {
+    updateGraph.addEdge(info[chunk], infoCollected);
+    updateGraph.addEdge(harvest[chunk], harvestResolved);
+  }
+
+  updateGraph.addEdge(harvestResolved, sourcesUpdate);
+
+  for (std::size_t chunk = 0; chunk < harvest.size(); ++chunk)
+  {
+    updateGraph.addEdge(harvest[chunk], movement[chunk]);
+    updateGraph.addEdge(infoCollected, movement[chunk]);
+    updateGraph.addEdge(movement[chunk], render[chunk]);
+    updateGraph.addEdge(harvestResolved, life[chunk]);
+    // Both phases change the shape of an agent
+    updateGraph.addEdge(render[chunk], indication[chunk]);
+    updateGraph.addEdge(info[chunk], indication[chunk]);
+  }
+}
+
+/**
+ * @brief Sorts agents that move into cells, in parallel and without locks.
+ * Agents are split into contiguous blocks and every block counts its agents
+ * per cell. Prefix sums of the counts give every block its own place in
+ * every cell, where the block then puts its agents. Agents of a cell are
+ * therefore always ordered by index, however many blocks there are
+ */
+void Simulation::Grid::rebuildAgents(const Manager<AgentSettings> & agentManager,
+                                     ThreadPool & threadPool)
+{
+  const auto agentsCount = agentManager.getAgentsCount();
+  const auto cellsCount = width * height;
+  const auto blocksCount = std::max<std::size_t>(
+        std::min(threadPool.getThreadsCount() + 1,
+                 (agentsCount + gridBlockSize - 1) / gridBlockSize), 1);
+  const auto blockFirst = [agentsCount, blocksCount](std::size_t block)
+  {
+    return agentsCount * block / blocksCount;
+  };
+  const auto cellOf = [this, & agentManager](std::size_t index)
+  {
+    return flatIndex(worldToGrid(agentManager.getComponent<Orientation>(index).position));
+  };
+
+  blockOffsets.assign(blocksCount * cellsCount, 0);
+
+  threadPool.parallelFor(0, blocksCount, 1, [&](std::size_t first, std::size_t last)
+  {
+    for (auto block = first; block < last; ++block)
+    {
+      auto counts = blockOffsets.data() + block * cellsCount;
+
+      agentManager.forGroupMatching<Movement>(blockFirst(block), blockFirst(block + 1),
+                                              [counts, & cellOf](std::size_t index)
+      {
+        ++counts[cellOf(index)];
+      });
+    }
+  });
+
+  // Sizes of cells, then their starts
+  threadPool.parallelFor(0, cellsCount, gridCellsGrain, [&](std::size_t first, std::size_t last)
+  {
+    for (auto cell = first; cell < last; ++cell)
+    {
+      std::size_t size = 0;
+
+      for (std::size_t block = 0; block < blocksCount; ++block)
+      {
+        size += blockOffsets[block * cellsCount + cell];
+      }
+
+      agentStarts[cell] = size;
+    }
+  });
+
+  std::size_t start = 0;
+
+  for (std::size_t cell = 0; cell < cellsCount; ++cell)
+  {
+    const auto size = agentStarts[cell];
+
+    agentStarts[cell] = start;
+    start += size;
+  }
+
+  agentStarts[cellsCount] = start;
+  agentIndexes.resize(start);
+
+  threadPool.parallelFor(0, cellsCount, gridCellsGrain, [&](std::size_t first, std::size_t last)
+  {
+    for (auto cell = first; cell < last; ++cell)
+    {
+      auto position = agentStarts[cell];
+
+      for (std::size_t block = 0; block < blocksCount; ++block)
+      {
+        auto & count = blockOffsets[block * cellsCount + cell];
+        const auto blockPosition = position;
+
+        position += count;
+        count = blockPosition;
+      }
+    }
+  });
+
+  threadPool.parallelFor(0, blocksCount, 1, [&](std::size_t first, std::size_t last)
+  {
+    for (auto block = first; block < last; ++block)
+    {
+      auto offsets = blockOffsets.data() + block * cellsCount;
+
+      agentManager.forGroupMatching<Movement>(blockFirst(block), blockFirst(block + 1),
+                                              [this, offsets, & cellOf](std::size_t index)
+      {
+        agentIndexes[offsets[cellOf(index)]++] = index;
+      });
+    }
+  });
+}
+
+/**
+ * @brief Performs logic upon game entities
+ */
+void Simulation::update(float delta)
+{
+  // Update helping grid
+  grid.rebuildAgents(agentManager, threadPool);
+
+  // Agents collect what their neighbors knew at the start of the tick, so
+  // the result doesn't depend on the order agents are processed in
+  knowledge.resize(agentManager.getAgentsCount());
+
+  threadPool.parallelFor(0, knowledge.size(), knowledgeGrain,
+                         [this](std::size_t first, std::size_t last)
+  {
+    agentManager.forGroup(first, last, [this](std::size_t index)
+    {
+      knowledge[index] = agentManager.matchesSignature<InfoCollection>(index) ?
+                         agentManager.getComponent<Information>(index).value :
+                         std::bitset<Information::size>{};
+    });
+  });
+
+  updateAgentsCount = agentManager.getAgentsCount();
+  updateDelta = delta;
+
+  switch (updateMode)
+  {
+  case UpdateMode::Tuned:
+    updateTuned(delta);
+    break;
+
+  case UpdateMode::Graph:
+    updateGraph.run();
+    break;
+
+  case UpdateMode::Team:
+    updateInTeam(delta);
+    break;
+
+  case UpdateMode::Fused:
+    updateFused(delta);
+    break;
+  }
+}
+
+/**
+ * @brief Runs the update on a team of threads. Every thread goes through all
+ * of the phases for its own range of agents and energy sources, so the only
+ * barriers needed are the one between collecting information from neighbors
+ * and moving, and the one before energy of harvested sources is consumed
+ * @param delta - time delta
+ */
+void Simulation::updateInTeam(float delta)
+{
+  const auto teamSize = phaseBarrier.getCount();
+
+  threadPool.runTeam(teamSize, [this, delta, teamSize](std::size_t member)
+  {
+    const auto first = updateAgentsCount * member / teamSize;
+    const auto last = updateAgentsCount * (member + 1) / teamSize;
+
+    agentManager.forGroupMatching<Harvesting>(first, last, [this](std::size_t index)
+    {
+      lookForEnergy(index);
+    });
+    agentManager.forGroupMatching<InfoCollection>(first, last, [this](std::size_t index)
+    {
+      collectInfo(index);
+    });
+
+    // Neighbors can belong to any thread, so nobody moves until everyone has
+    // collected information. Every thread then hands out energy of its own
+    // range of harvested sources and updates them, nobody else uses sources
+    // after harvesting
+    phaseBarrier.arriveAndWait();
+
+    const auto sourcesCount = energySources.size();
+    const auto firstSource = sourcesCount * member / teamSize;
+    const auto lastSource = sourcesCount * (member + 1) / teamSize;
+
+    resolveHarvest(firstSource, lastSource);
+    energySources.regenerate(firstSource, lastSource, delta);
+
+    agentManager.forGroupMatching<Movement>(first, last, [this, delta](std::size_t index)
+    {
+      moveAgent(index, delta);
+    });
+    agentManager.forGroupMatching<Render>(first, last, [this](std::size_t index)
+    {
+      updateAgentPositionAndRotation(index);
+    });
+
+    // Harvested energy has to reach agents before they consume it
+    phaseBarrier.arriveAndWait();
+
+    agentManager.forGroupMatching<Life>(first, last, [this, delta](std::size_t index)
+    {
+      applyAgentMetabolism(index, delta);
+    });
+    agentManager.forGroupMatching<InfoIndication>(first, last, [this](std::size_t index)
+    {
+      indicateAgentKnowledge(index);
+    });
+  });
+}
+
+/**
+ * @brief Declares the systems of the update and the components they access,
+ * so the pipeline can tell which of them can be executed chunk by chunk
+ */
+void Simulation::buildPipeline()
+{
+  using AgentPipeline = Pipeline<AgentSettings>;
+
+  AgentPipeline::Access harvesting;
+  AgentPipeline::Access infoCollection;
+  AgentPipeline::Access movement;
+  AgentPipeline::Access render;
+  AgentPipeline::Access life;
+  AgentPipeline::Access infoIndication;
+
+  // Energy is given to agents when claims are resolved, after the system
+  harvesting.reads = AgentPipeline::components<Identity, Orientation, Destination>();
+  harvesting.writes = AgentPipeline::components<Destination>();
+  infoCollection.reads = AgentPipeline::components<Orientation, Information>();
+  infoCollection.writes = AgentPipeline::components<Information>();
+  infoCollection.readsOthers = AgentPipeline::components<Orientation>();
+  movement.reads = AgentPipeline::components<Orientation, Destination>();
+  movement.writes = AgentPipeline::components<Orientation>();
+  render.reads = AgentPipeline::components<Orientation, Destination, Graphic>();
+  render.writes = AgentPipeline::components<Graphic>();
+  life.reads = AgentPipeline::components<Energy>();
+  life.writes = AgentPipeline::components<Energy>();
+  infoIndication.reads = AgentPipeline::components<Information, Graphic>();
+  infoIndication.writes = AgentPipeline::components<Graphic>();
+
+  harvestingSystem = pipeline.addSystem<Harvesting>(harvesting, [this](std::size_t index)
+  {
+    lookForEnergy(index);
+  });
+  pipeline.addSystem<InfoCollection>(infoCollection, [this](std::size_t index)
+  {
+    collectInfo(index);
+  });
+  // Changes positions that info collection reads from neighbors, so it
+  // starts a new group
+  pipeline.addSystem<Movement>(movement, [this](std::size_t index)
+  {
+    moveAgent(index, updateDelta);
+  });
+  pipeline.addSystem<Render>(render, [this](std::size_t index)
+  {
+    updateAgentPositionAndRotation(index);
+  });
+  pipeline.addSystem<Life>(life, [this](std::size_t index)
+  {
+    applyAgentMetabolism(index, updateDelta);
+  });
+  pipeline.addSystem<InfoIndication>(infoIndication, [this](std::size_t index)
+  {
+    indicateAgentKnowledge(index);
+  });
+
+  for (const auto name : { "Harvesting", "Info collection", "Movement", "Render", "Life",
+                           "Info indication" })
+  {
+    tuner.addSystem(name);
+    costModels.emplace_back();
+  }
+}
+
+/**
+ * @brief Runs the update group by group. Systems of a group are executed
+ * one after another over each chunk, so the chunk's components are loaded
+ * from memory once per group instead of once per system
+ * @param delta - time delta
+ */
+void Simulation::updateFused(float delta)
+{
+  const auto sourcesGroup = pipeline.getGroupOf(harvestingSystem);
+  ThreadPool::TaskGroup sourcesUpdate{threadPool};
+
+  for (std::size_t group = 0; group < pipeline.getGroups().size(); ++group)
+  {
+    threadPool.parallelFor(0, updateAgentsCount, pipeline.getChunkSize(group, fusedChunkBytes),
+                           [this, group](std::size_t first, std::size_t last)
+    {
+      pipeline.runGroup(group, first, last);
+    }, ThreadPool::Schedule::Affine);
+
+    // Energy sources are not used after harvesting
+    if (group == sourcesGroup)
+    {
+      resolveHarvest();
+      sourcesUpdate.run([this, delta] { regenerateEnergySources(delta); });
+    }
+  }
+
+  sourcesUpdate.wait();
+}
+
+/**
+ * @brief Executes systems one after another, each of them either serially
+ * or in parallel, as the tuner decides from measured costs
+ * @param delta - time delta
+ */
+void Simulation::updateTuned(float delta)
+{
+  ThreadPool::TaskGroup sourcesUpdate{threadPool};
+
+  for (std::size_t system = 0; system < pipeline.getSystemsCount(); ++system)
+  {
+    const auto decision = tuner.decide(system, updateAgentsCount,
+                                       threadPool.getActiveWorkersCount() + 1);
+    const auto start = std::chrono::steady_clock::now();
+
+    if (decision.parallel)
+    {
+      auto & costModel = costModels[system];
+      const auto blockSize = costModel.getBlockSize();
+      // Chunks must not share blocks of the cost model
+      const auto grain = (decision.grain + blockSize - 1) / blockSize * blockSize;
+      const auto partitionsCount = std::min(threadPool.getActiveWorkersCount() + 1,
+                                            ThreadPool::getMaxPartitionsCount());
+
+      costModel.resize(updateAgentsCount);
+      threadPool.parallelFor(0, costModel.getBlocksCount(), weightBlocksGrain,
+                             [this, system, & costModel](std::size_t first, std::size_t last)
+      {
+        costModel.updateWeights(first, last, [this, system](std::size_t firstAgent,
+                                                            std::size_t lastAgent)
+        {
+          return pipeline.countMatching(system, firstAgent, lastAgent);
+        });
+      });
+      costModel.split(0, updateAgentsCount, partitionsCount, partitionBoundaries);
+
+      threadPool.parallelFor(partitionBoundaries, grain,
+                             [this, system, & costModel](std::size_t first, std::size_t last)
+      {
+        const auto chunkStart = std::chrono::steady_clock::now();
+
+        pipeline.runSystem(system, first, last);
+        costModel.record(first, last, std::chrono::steady_clock::now() - chunkStart);
+      });
+    }
+    else
+    {
+      pipeline.runSystem(system, 0, updateAgentsCount);
+    }
+
+    tuner.record(system, decision, updateAgentsCount,
+                 std::chrono::steady_clock::now() - start);
+
+    // Energy sources are not used after harvesting
+    if (system == harvestingSystem)
+    {
+      resolveHarvest();
+      sourcesUpdate.run([this, delta] { regenerateEnergySources(delta); });
+    }
+  }
+
+  sourcesUpdate.wait();
+}
+
+/**
+ * @brief Gives energy of every claimed source to the agent that claimed it.
+ * Every agent claims at most one source, so sources are resolved in
+ * parallel without touching the same agent twice
+ */
+void Simulation::resolveHarvest()
+{
+  threadPool.parallelFor(0, energySources.size(), harvestGrain,
+                         [this](std::size_t first, std::size_t last)
+  {
+    resolveHarvest(first, last);
+  });
+}
+
+/**
+ * @brief Gives energy of claimed sources in a range to the agents that
+ * claimed them
+ * @param first - index of the first source
+ * @param last - index past the last source
+ */
+void Simulation::resolveHarvest(std::size_t first, std::size_t last)
+{
+  for (auto i = first; i < last; ++i)
+  {
+    auto & claim = harvestClaims[i];
+    const auto index = claim.load(std::memory_order_relaxed);
+
+    if (index == noClaim)
+    {
+      continue;
+    }
+
+    auto & energy = agentManager.getComponent<Energy>(index);
+
+    energy.value = std::min(500.f, energy.value + energySources.reset(i));
+    claim.store(noClaim, std::memory_order_relaxed);
+  }
+}
+
+/**
+ * @brief Lets energy sources accumulate energy
+ * @param delta - time delta
+ */
+void Simulation::regenerateEnergySources(float delta)
+{
+  threadPool.parallelFor(0, energySources.size(), regenerationGrain,
+                         [this, delta](std::size_t first, std::size_t last)
+  {
+    energySources.regenerate(first, last, delta);
+  });
+}
+
+/**
+ * @brief Moves an Agent
+ * @param index - index of an Agent
+ * @param delta - time delta that affects movement
+ */
+void Simulation::moveAgent(std::size_t index, float delta)
+{
+  auto & orientation = agentManager.getComponent<Orientation>(index);
+  const auto & destination = agentManager.getComponent<Destination>(index);
+  const auto towardsDestination = destination.position - orientation.position;
+  const auto distance = Utils::magnitude(towardsDestination);
+  const auto step = orientation.velocity * delta;
+
+  if (step > distance)
+  {
+    orientation.position = destination.position;
+  }
+  else
+  {
+    orientation.position += Utils::normal(towardsDestination) * step;
+
+    // The world is seamless so agents move from one side to another
+    if (orientation.position.x > worldSize.x)
+    {
+      orientation.position.x -= worldSize.x;
+    }
+    else if (orientation.position.x < 0)
+    {
+      orientation.position.x += worldSize.x;
+    }
+
+    if (orientation.position.y > worldSize.y)
+    {
+      orientation.position.y -= worldSize.y;
+    }
+    else if (orientation.position.y < 0)
+    {
+      orientation.position.y += worldSize.y;
+    }
+  }
+}
+
+/**
+ * @brief Updates rotation of Agent's shape and positions it's drawn between
+ * @param index - index of an Agent
+ */
+void Simulation::updateAgentPositionAndRotation(std::size_t index)
+{
+  const auto & orientation = agentManager.getComponent<Orientation>(index);
+  const auto & destination = agentManager.getComponent<Destination>(index);
+  auto & graphic = agentManager.getComponent<Graphic>(index);
+  const auto towardsDestination = destination.position - orientation.position;
+
+  if (Utils::magnitude(towardsDestination) > 0)
+  {
+    auto angle = Utils::angle({ 0.f, -1.f }, towardsDestination);
+
+    // We need an angle in a clock-wise direction
+    if (towardsDestination.x < 0)
+    {
+      angle = 360.f - angle;
+    }
+
+    graphic.rotation = angle;
+  }
+
+  graphic.previousPosition = graphic.position;
+  graphic.position = orientation.position;
+}
+
+/**
+ * @brief Reduces Agent's level of energy
+ * @param index - index of an Agent
+ */
+void Simulation::applyAgentMetabolism(std::size_t index, float delta)
+{
+  auto & energy = agentManager.getComponent<Energy>(index);
+
+  energy.value -= delta * energy.consumptionRate;
+
+  if (energy.value < 0)
+  {
+    agentManager.kill(index);
+  }
+}
+
+/**
+ * @brief Visually indicates Agent's current level of energy
+ * @param index - index of an Agent
+ */
+void Simulation::indicateAgentEnergyLevel(std::size_t index)
+{
+  const auto & energy = agentManager.getComponent<Energy>(index);
+  auto & graphic = agentManager.getComponent<Graphic>(index);
+  const auto shade = std::min(static_cast<float>(energy.value) / energy.max + 0.2f, 1.f);
+  const auto level = static_cast<std::uint8_t>(255 * shade);
+
+  // Shade of yellow
+  graphic.color = Graphic::rgb(level, level, 0);
+}
+
+/**
+ * @brief Visually indicates how much an Agent knows
+ * @param index - index of an Agent
+ */
+void Simulation::indicateAgentKnowledge(std::size_t index)
+{
+  const auto & info = agentManager.getComponent<Information>(index);
+  auto & graphic = agentManager.getComponent<Graphic>(index);
+  const auto count = info.value.count();
+
+  if (count == 0)
+  {
+    graphic.color = Graphic::yellow;
+  }
+  else if (count == info.value.size())
+  {
+    graphic.color = Graphic::green;
+  }
+  else
+  {
+    graphic.color = Graphic::blue;
+  }
+}
+
+/**
+ * @brief Moves an Agent towards a Source Energy in his field of view.
+ * When the Agent reaches the source, he replenishes his energy level
+ * @param index - index of an Agent
+ */
+void Simulation::lookForEnergy(std::size_t index)
+{
+  auto & arena = threadPool.getScratchArena();
+  const Arena::Scope scope{arena};
+  auto & orientation = agentManager.getComponent<Orientation>(index);
+  auto & destination = agentManager.getComponent<Destination>(index);
+  auto availableSources = findSourcesInRange(orientation.position,
+                                             orientation.viewRange, arena);
+  const auto reachedDestination = orientation.position == destination.position;
+
+  // We are interested only in sources with some minimum energy level or more
+  // TODO: Make this value more reasonable, not just a constant
+  const auto minimumPreferableLevel = 20.f;
+  ArenaVector<std::size_t> preferableSources{arena};
+
+  for (const auto sourceIndex : availableSources)
+  {
+    if (energySources.getCurrentLevel(sourceIndex) >= minimumPreferableLevel)
+    {
+      preferableSources.push_back(sourceIndex);
+    }
+  }
+
+  // In this scenario we completely ignore sources with low energy level
+  availableSources = std::move(preferableSources);
+
+  // No sources found. Move in random direction
+  if (availableSources.empty())
+  {
+    if (reachedDestination)
+    {
+      const auto & identity = agentManager.getComponent<Identity>(index);
+      RandomStream random{seed, RandomStream::Domain::AgentMovement, identity.id,
+                          static_cast<std::uint32_t>(ticksCount)};
+
+      destination.position = orientation.position + Utils::normal(
+            random.uniformVector(-10.f, 10.f)) * orientation.viewRange;
+
+      if (destination.position.x > worldSize.x)
+      {
+        destination.position.x = worldSize.x;
+      }
+      else if (destination.position.x < 0)
+      {
+        destination.position.x = 0;
+      }
+
+      if (destination.position.y > worldSize.y)
+      {
+        destination.position.y = worldSize.y;
+      }
+      else if (destination.position.y < 0)
+      {
+        destination.position.y = 0;
+      }
+    }
+  }
+  // Move to the source and replenish energy
+  else
+  {
+    const auto richestSourceItr = std::max_element(std::begin(availableSources),
+                                                   std::end(availableSources),
+                                                   [this](auto left, auto right)
+    {
+      return energySources.getCurrentLevel(left) < energySources.getCurrentLevel(right);
+    });
+    const auto sourcePosition = energySources.getPosition(*richestSourceItr);
+
+    if (destination.position == sourcePosition)
+    {
+      if (reachedDestination)
+      {
+        claimEnergySource(*richestSourceItr, index);
+      }
+    }
+    else
+    {
+      destination.position = sourcePosition;
+    }
+  }
+}
+
+/**
+ * @brief Claims energy of a source for an Agent. Of all agents that claim
+ * the same source during a tick, the one with the lowest index gets the
+ * energy, no matter in which order the claims are made. Energy itself is
+ * handed out by resolveHarvest, so levels of sources stay the same while
+ * agents choose between them
+ * @param source - index of an Energy Source
+ * @param index - index of an Agent
+ */
+void Simulation::claimEnergySource(std::size_t source, std::size_t index)
+{
+  auto & claim = harvestClaims[source];
+  auto current = claim.load(std::memory_order_relaxed);
+
+  // Claims are read after the update synchronizes with the threads that
+  // made them, so no ordering is needed here
+  while (index < current &&
+         !claim.compare_exchange_weak(current, index, std::memory_order_relaxed))
+  {
+  }
+}
+
+/**
+ * @brief Collects information from nearby agents
+ * @param index - index of an Agent
+ */
+void Simulation::collectInfo(std::size_t index)
+{
+  auto & arena = threadPool.getScratchArena();
+  const Arena::Scope scope{arena};
+  const auto & orientation = agentManager.getComponent<Orientation>(index);
+  auto & info = agentManager.getComponent<Information>(index);
+
+  const auto nearbyAgents = findAgentsInRange(orientation.position,
+                                              info.shareRange, arena);
+
+  for (const auto i : nearbyAgents)
+  {
+    info.value |= knowledge[i];
+  }
+}
+
+/**
+ * @brief Searches for Energy Sources in specific area
+ * @param position - position in a world
+ * @param range - range in which search is performed
+ * @param arena - memory for the result
+ * @return Vector with indexes of found Energy Sources
+ */
+ArenaVector<std::size_t> Simulation::findSourcesInRange(sf::Vector2f position,
+                                                         float range,
+                                                         Arena & arena) const
+{
+  auto top = position.y - range > 0 ? position.y - range : 0;
+  auto bottom = position.y + range < worldSize.y ? position.y + range : worldSize.y;
+  auto left = position.x - range > 0 ? position.x - range : 0;
+  auto right = position.x + range < worldSize.x ? position.x + range : worldSize.x;
+
+  const auto topLeft = grid.worldToGrid({ left, top });
+  const auto bottomRight = grid.worldToGrid({ right, bottom });
+
+  ArenaVector<std::size_t> indexes{arena};
+
+  for (std::size_t x = topLeft.x; x < bottomRight.x; ++x)
+  {
+    for (std::size_t y = topLeft.y; y < bottomRight.y; ++y)
+    {
+      const auto & sources = grid.cell({ x, y }).sources;
+
+      for (const auto i : sources)
+      {
+        const auto distance = Utils::magnitude(energySources.getPosition(i) - position);
+
+        if (distance < range)
+        {
+          indexes.push_back(i);
+        }
+      }
+    }
+  }
+
+  return indexes;
+}
+
+/**
+ * @brief Searches for Agents in specific area
+ * @param position - position in a world
+ * @param range - range in which search is performed
+ * @param arena - memory for the result
+ * @return Vector with indexed of found Agents
+ */
+ArenaVector<std::size_t> Simulation::findAgentsInRange(sf::Vector2f position,
+                                                        float range,
+                                                        Arena & arena) const
+{
+  auto top = position.y - range > 0 ? position.y - range : 0;
+  auto bottom = position.y + range < worldSize.y ? position.y + range : worldSize.y;
+  auto left = position.x - range > 0 ? position.x - range : 0;
+  auto right = position.x + range < worldSize.x ? position.x + range : worldSize.x;
+
+  const auto topLeft = grid.worldToGrid({ left, top });
+  const auto bottomRight = grid.worldToGrid({ right, bottom });
+
+  ArenaVector<std::size_t> indexes{arena};
+
+  for (std::size_t x = topLeft.x; x < bottomRight.x; ++x)
+  {
+    for (std::size_t y = topLeft.y; y < bottomRight.y; ++y)
+    {
+      for (const auto i : grid.agents({ x, y }))
+      {
+        const auto & orientation = agentManager.getComponent<Orientation>(i);
+        const auto distance = Utils::magnitude(orientation.position - position);
+
+        if (distance < range)
+        {
+          indexes.push_back(i);
+        }
+      }
+    }
+  }
+
+  return indexes;
+}
+
+/**
+ * @brief Creates new Agents
+ */
+void Simulation::createAgents()
+{
+  if (agentManager.getAgentsCount() >= maxAgentsNumber)
+  {
+    return;
+  }
+
+  const auto groupSize = maxAgentsNumber / 20;
+
+  spawnAgents(std::min(groupSize, maxAgentsNumber - agentManager.getAgentsCount()));
+}
+
+/**
+ * @brief Creates a batch of agents in parallel. Ids are reserved up front
+ * and every agent draws from its own random stream, so the batch is the
+ * same no matter how it's split between threads
+ * @param count - number of agents
+ */
+void Simulation::spawnAgents(std::size_t count)
+{
+  if (count == 0)
+  {
+    return;
+  }
+
+  const auto first = agentManager.createIndexes(count);
+  const auto firstId = nextAgentId;
+
+  nextAgentId += count;
+
+  threadPool.parallelFor(first, first + count, creationGrain,
+                         [this, first, firstId](std::size_t begin, std::size_t end)
+  {
+    for (auto index = begin; index < end; ++index)
+    {
+      initializeAgent(index, firstId + (index - first));
+    }
+  });
+}
+
+/**
+ * @brief Adds random components to a newly created agent
+ * @param index - index of the agent
+ * @param id - identity of the agent
+ */
+void Simulation::initializeAgent(std::size_t index, std::uint64_t id)
+{
+  auto & identity = agentManager.addComponent<Identity>(index);
+  auto & orientation = agentManager.addComponent<Orientation>(index);
+  auto & destination = agentManager.addComponent<Destination>(index);
+  auto & info = agentManager.addComponent<Information>(index);
+  auto & graphic = agentManager.addComponent<Graphic>(index);
+
+  identity.id = id;
+
+  RandomStream random{seed, RandomStream::Domain::AgentCreation, id, 0};
+  const auto energy = random.uniform(100.f, 300.f);
+
+  agentManager.addComponent<Energy>(index, energy, random.uniform(15.f, 25.f));
+
+  orientation.position.x = random.uniform(0.f, worldSize.x);
+  orientation.position.y = random.uniform(0.f, worldSize.y);
+  orientation.velocity = 300.f;
+  orientation.viewRange = random.uniform(100.f, 250.f);
+  destination.position = orientation.position;
+  graphic.previousPosition = orientation.position;
+  graphic.position = orientation.position;
+  info.value = random.bitset<Information::size>(0.1f);
+}
+
+/**
+ * @brief Creates sources of energy and places them in the world
+ */
+void Simulation::createEnergySources()
+{
+  // Sources are generated in parallel, each from its own random stream,
+  // and registered in the grid afterwards
+  energySources.resize(maxSourcesNumber);
+  harvestClaims = std::vector<std::atomic<std::size_t>>(maxSourcesNumber);
+
+  for (auto & claim : harvestClaims)
+  {
+    claim.store(noClaim, std::memory_order_relaxed);
+  }
+
+  threadPool.parallelFor(0, maxSourcesNumber, creationGrain,
+                         [this](std::size_t first, std::size_t last)
+  {
+    for (auto i = first; i < last; ++i)
+    {
+      RandomStream random{seed, RandomStream::Domain::EnergySourceCreation, i, 0};
+      const auto maxCapacity = random.uniform(25.f, 100.f);
+      const auto initialLevel = random.uniform(0.f, maxCapacity);
+      const auto regenRate = random.uniform(20.f, 50.f);
+      const auto x = random.uniform(0.f, worldSize.x);
+      const auto position = sf::Vector2f{ x, random.uniform(0.f, worldSize.y) };
+
+      energySources.set(i, maxCapacity, initialLevel, regenRate, position);
+    }
+  });
+
+  for (std::size_t i = 0; i < maxSourcesNumber; ++i)
+  {
+    grid.cell(grid.worldToGrid(energySources.getPosition(i))).sources.push_back(i);
+  }
+}
+
+}
@@ -0,0 +1,1204 @@
+#include <algorithm>
+#include <cassert>
+
+#include "ThreadPool.hpp"
+
+namespace ABM
+{
+namespace
+{
+// Pool and worker that the current thread belongs to
+thread_local const ThreadPool * currentPool = nullptr;
+thread_local std::size_t currentWorker = 0;
+// Whether the current thread runs a member of a team
+thread_local bool teamMember = false;
+
+/**
+ * @brief Returns current time in nanoseconds
+ */
+std::uint64_t now() noexcept
+{
+  using namespace std::chrono;
+
+  return static_cast<std::uint64_t>(
+        duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * @brief Adds a value to a counter that has only one writer
+ */
+void add(std::atomic<std::uint64_t> & counter, std::uint64_t value) noexcept
+{
+  counter.store(counter.load(std::memory_order_relaxed) + value,
+                std::memory_order_relaxed);
+}
+
+/**
+ * @brief Raises a counter that has only one writer to a given value if it's bigger
+ */
+void updateMax(std::atomic<std::uint64_t> & counter, std::uint64_t value) noexcept
+{
+  if (value > counter.load(std::memory_order_relaxed))
+  {
+    counter.store(value, std::memory_order_relaxed);
+  }
+}
+
+/**
+ * @brief Cheap xorshift generator for picking victims to steal from
+ */
+std::uint32_t nextRandom(std::uint32_t & state) noexcept
+{
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+
+  return state;
+}
+}
+
+/**
+ * @brief C-tor. Splits the range into equal partitions
+ */
+ThreadPool::RangeJob::RangeJob(std::size_t first, std::size_t last,
+                               std::size_t grain, std::size_t partitionsCount,
+                               std::size_t helpers, Body invoke, void * body,
+                               bool timed, const std::size_t * boundaries)
+  : grain(grain), partitionsCount(partitionsCount), participants(helpers + 1),
+    invoke(invoke), body(body), latch(helpers), startTime(timed ? now() : 0)
+{
+  assert(partitionsCount != 0 && partitionsCount <= maxPartitions);
+
+  const auto length = last - first;
+
+  for (std::size_t i = 0; i < partitionsCount; ++i)
+  {
+    if (boundaries != nullptr)
+    {
+      assert(boundaries[i] <= boundaries[i + 1]);
+
+      partitions[i].next = boundaries[i];
+      partitions[i].last = boundaries[i + 1];
+    }
+    else
+    {
+      partitions[i].next = first + length * i / partitionsCount;
+      partitions[i].last = first + length * (i + 1) / partitionsCount;
+    }
+  }
+}
+
+/**
+ * @brief Processes chunks of a given partition and then helps with the rest
+ * of them until there are no chunks left. An exception of the body is kept
+ * for the calling thread instead of leaving a worker
+ */
+void ThreadPool::RangeJob::run(std::size_t partition) noexcept
+{
+  const auto start = startTime != 0 ? now() : 0;
+
+  try
+  {
+    for (std::size_t i = 0; i < partitionsCount; ++i)
+    {
+      auto & current = partitions[(partition + i) % partitionsCount];
+
+      while (!failed.load(std::memory_order_relaxed))
+      {
+        const auto first = current.next.fetch_add(grain, std::memory_order_relaxed);
+
+        if (first >= current.last)
+        {
+          break;
+        }
+
+        invoke(body, first, std::min(first + grain, current.last));
+      }
+    }
+  }
+  catch (...)
+  {
+    if (!failed.exchange(true, std::memory_order_relaxed))
+    {
+      exception = std::current_exception();
+    }
+  }
+
+  if (start != 0)
+  {
+    workTime.fetch_add(now() - start, std::memory_order_relaxed);
+  }
+}
+
+/**
+ * @brief Makes one node wait for another one
+ * @param predecessor - node that has to be finished first
+ * @param successor - node that waits for the predecessor
+ */
+void ThreadPool::TaskGraph::addEdge(Node predecessor, Node successor)
+{
+  assert(predecessor < successor && successor < nodes.size());
+
+  nodes[predecessor]->successors.push_back(successor);
+  ++nodes[successor]->dependencies;
+}
+
+/**
+ * @brief Runs all of the tasks and waits for them. The calling thread
+ * executes one of the root nodes itself and then helps the pool. Once a
+ * task throws, the rest of the nodes are only released without being
+ * executed, and the exception is rethrown when all of them are done
+ */
+void ThreadPool::TaskGraph::run()
+{
+  assert(pendingNodes == 0);
+
+  if (nodes.empty())
+  {
+    return;
+  }
+
+  roots.clear();
+
+  for (std::size_t i = 0; i < nodes.size(); ++i)
+  {
+    auto & node = *nodes[i];
+
+    node.pendingDependencies.store(node.dependencies, std::memory_order_relaxed);
+
+    if (node.dependencies == 0)
+    {
+      roots.push_back(i);
+    }
+  }
+
+  pendingNodes.store(nodes.size(), std::memory_order_relaxed);
+  workTime.store(0, std::memory_order_relaxed);
+
+  const auto startTime = threadPool.options.elastic ? now() : 0;
+  std::array<Task, 64> batch;
+  std::size_t batchSize = 0;
+
+  for (std::size_t i = 1; i < roots.size(); ++i)
+  {
+    batch[batchSize++] = makeTask(roots[i]);
+
+    if (batchSize == batch.size())
+    {
+      threadPool.submitBatch(batch.data(), batchSize);
+      batchSize = 0;
+    }
+  }
+
+  threadPool.submitBatch(batch.data(), batchSize);
+
+  execute(roots.front());
+
+  threadPool.helpUntil([this]
+  {
+    return pendingNodes.load(std::memory_order_acquire) == 0;
+  });
+
+  if (startTime != 0)
+  {
+    threadPool.recordParallelRegion(workTime.load(std::memory_order_relaxed),
+                                    now() - startTime,
+                                    threadPool.getActiveWorkersCount() + 1);
+  }
+
+  if (failed.load(std::memory_order_relaxed))
+  {
+    auto error = std::move(exception);
+
+    exception = nullptr;
+    failed.store(false, std::memory_order_relaxed);
+    std::rethrow_exception(error);
+  }
+}
+
+/**
+ * @brief Wraps execution of a node into a pool's task
+ */
+ThreadPool::Task ThreadPool::TaskGraph::makeTask(Node node)
+{
+  return Task{[this, node] { execute(node); }};
+}
+
+/**
+ * @brief Executes a node and releases its successors. The first successor
+ * that becomes ready is executed right away on the same thread, so a chain
+ * of nodes doesn't go through the queues and stays in the same cache
+ */
+void ThreadPool::TaskGraph::execute(Node node)
+{
+  while (true)
+  {
+    auto & data = *nodes[node];
+    auto hasNext = false;
+    Node next = 0;
+
+    // After a failure nodes are skipped, since they may need results of the
+    // failed one, but they are still released, otherwise the run would
+    // never finish
+    if (!failed.load(std::memory_order_relaxed))
+    {
+      try
+      {
+        if (threadPool.options.elastic)
+        {
+          const auto start = now();
+
+          data.work();
+          workTime.fetch_add(now() - start, std::memory_order_relaxed);
+        }
+        else
+        {
+          data.work();
+        }
+      }
+      catch (...)
+      {
+        if (!failed.exchange(true, std::memory_order_relaxed))
+        {
+          exception = std::current_exception();
+        }
+      }
+    }
+
+    for (const auto successor : data.successors)
+    {
+      if (nodes[successor]->pendingDependencies.fetch_sub(1, std::memory_order_acq_rel) != 1)
+      {
+        continue;
+      }
+
+      if (!hasNext)
+      {
+        hasNext = true;
+        next = successor;
+      }
+      else
+      {
+        threadPool.submit(makeTask(successor));
+      }
+    }
+
+    // The graph may be destroyed as soon as the last node is finished
+    pendingNodes.fetch_sub(1, std::memory_order_release);
+
+    if (!hasNext)
+    {
+      return;
+    }
+
+    node = next;
+  }
+}
+
+/**
+ * @brief C-tor
+ * @param threadNumber - number of worker threads
+ * @param options - scheduling options
+ */
+ThreadPool::ThreadPool(std::size_t threadNumber, ThreadPoolOptions options)
+  : options(options),
+    topology(Topology::detect()),
+    activeWorkers(threadNumber),
+    metricsEnabled(options.collectMetrics)
+{
+  assert(threadNumber != 0);
+
+  const auto cpus = topology.selectCpus(threadNumber, options.skipSmtSiblings,
+                                        Topology::getAllowedCpus());
+
+  // Workers beyond the selected CPUs share them only as far as NUMA nodes
+  // for stealing are concerned
+  for (std::size_t i{0}; i < threadNumber; ++i)
+  {
+    workers.emplace_back(new Worker(static_cast<std::uint32_t>(i) * 2654435761u + 1u,
+                                    cpus[i % cpus.size()], i < cpus.size()));
+  }
+
+  // Workers check whether there are threads reserved for background tasks,
+  // so those are started first
+  for (std::size_t i{0}; i < options.backgroundThreads; ++i)
+  {
+    backgroundThreads.emplace_back(& ThreadPool::backgroundLoop, this);
+  }
+
+  for (std::size_t i{0}; i < threadNumber; ++i)
+  {
+    threads.emplace_back(& ThreadPool::workerLoop, this, i);
+  }
+}
+
+/**
+ * @brief D-tor. Lets workers finish all pending tasks
+ */
+ThreadPool::~ThreadPool()
+{
+  done = true;
+
+  {
+    std::lock_guard<std::mutex> lock{parkingMutex};
+  }
+
+  parkingCondition.notify_all();
+  inactiveCondition.notify_all();
+  backgroundCondition.notify_all();
+
+  for (auto & thread : threads)
+  {
+    thread.join();
+  }
+
+  for (auto & thread : backgroundThreads)
+  {
+    thread.join();
+  }
+}
+
+/**
+ * @brief Puts a task to the current worker's deque or to the shared queue
+ */
+void ThreadPool::submit(Task && task)
+{
+  stamp(task);
+
+  if (currentPool != this || !workers[currentWorker]->tasks.push(std::move(task)))
+  {
+    pushShared(std::move(task));
+  }
+
+  wakeWorkers(1);
+}
+
+/**
+ * @brief Puts a number of tasks to the current worker's deque or publishes
+ * them to the shared queue at once
+ */
+void ThreadPool::submitBatch(Task * batch, std::size_t count)
+{
+  if (count == 0)
+  {
+    return;
+  }
+
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    stamp(batch[i]);
+  }
+
+  if (currentPool == this)
+  {
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      if (!workers[currentWorker]->tasks.push(std::move(batch[i])))
+      {
+        pushShared(std::move(batch[i]));
+      }
+    }
+  }
+  else if (!tasks.tryPushBatch(batch, count))
+  {
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      pushShared(std::move(batch[i]));
+    }
+  }
+
+  wakeWorkers(count);
+}
+
+/**
+ * @brief Puts a task to a mailbox of a specific worker. If the mailbox is
+ * full, the task goes to the shared queue instead
+ */
+void ThreadPool::submitTo(std::size_t workerIndex, Task && task)
+{
+  auto & worker = *workers[workerIndex];
+
+  stamp(task);
+
+  if (!worker.mailbox.tryPush(std::move(task)))
+  {
+    // Any worker can take the task from the shared queue, so it's enough to
+    // wake up one of them, whichever is parked
+    pushShared(std::move(task));
+    wakeWorkers(1);
+
+    return;
+  }
+
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  // There's no way to wake up a particular worker, so wake up all of them
+  if (worker.parked)
+  {
+    {
+      std::lock_guard<std::mutex> lock{parkingMutex};
+    }
+
+    parkingCondition.notify_all();
+    inactiveCondition.notify_all();
+  }
+}
+
+/**
+ * @brief Claims slots of all workers of a team, waiting until members of
+ * other teams are taken from them. Teams that share workers get them one
+ * after another, since two teams holding a part of each other's workers
+ * would wait for each other forever
+ * @param teamSize - number of members, including the calling thread
+ */
+void ThreadPool::claimTeamWorkers(std::size_t teamSize)
+{
+  helpUntil([this, teamSize] { return tryClaimTeamWorkers(teamSize); });
+}
+
+/**
+ * @brief Claims slots of all workers of a team or none of them
+ * @param teamSize - number of members, including the calling thread
+ */
+bool ThreadPool::tryClaimTeamWorkers(std::size_t teamSize)
+{
+  for (std::size_t member = 1; member < teamSize; ++member)
+  {
+    auto & worker = *workers[getTeamWorker(member)];
+
+    if (worker.teamTaskClaimed.exchange(true, std::memory_order_acquire))
+    {
+      while (--member != 0)
+      {
+        workers[getTeamWorker(member)]->teamTaskClaimed.store(false, std::memory_order_release);
+      }
+
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * @brief Hands a member of a team to a specific worker and wakes it up.
+ * The slot of the worker has to be claimed first
+ */
+void ThreadPool::submitTeamTask(std::size_t workerIndex, Task && task)
+{
+  auto & worker = *workers[workerIndex];
+
+  assert(worker.teamTaskClaimed.load(std::memory_order_relaxed));
+  assert(!worker.teamTaskReady.load(std::memory_order_relaxed));
+
+  stamp(task);
+  worker.teamTask = std::move(task);
+  worker.teamTaskReady.store(true, std::memory_order_release);
+
+  // The worker checks for its member under the lock before it goes to sleep
+  {
+    std::lock_guard<std::mutex> lock{parkingMutex};
+  }
+
+  parkingCondition.notify_all();
+  inactiveCondition.notify_all();
+}
+
+/**
+ * @brief Puts a task to the shared queue. If it's full, the calling thread
+ * executes pending tasks until there's some space
+ */
+void ThreadPool::pushShared(Task && task)
+{
+  while (!tasks.tryPush(std::move(task)))
+  {
+    if (!runPendingTask())
+    {
+      std::this_thread::yield();
+    }
+  }
+
+  if (metricsEnabled.load(std::memory_order_relaxed))
+  {
+    const auto size = tasks.size();
+    auto highWater = sharedQueueHighWater.load(std::memory_order_relaxed);
+
+    while (size > highWater &&
+           !sharedQueueHighWater.compare_exchange_weak(highWater, size,
+                                                      std::memory_order_relaxed))
+    {
+    }
+  }
+}
+
+/**
+ * @brief Remembers when a task was submitted if statistics are collected
+ */
+void ThreadPool::stamp(Task & task) noexcept
+{
+  task.setSubmitTime(metricsEnabled.load(std::memory_order_relaxed) ? now() : 0);
+}
+
+/**
+ * @brief Executes a top-level task on a worker thread and updates its
+ * statistics. Nothing else is running on the worker's stack afterwards, so
+ * the worker's arena is reset
+ */
+void ThreadPool::execute(Task & task, Worker & worker)
+{
+  if (!metricsEnabled.load(std::memory_order_relaxed))
+  {
+    task();
+    task = Task{};
+    worker.arena.reset();
+
+    return;
+  }
+
+  auto & counters = worker.counters;
+  const auto start = now();
+  const auto submitTime = task.getSubmitTime();
+
+  if (submitTime != 0 && start > submitTime)
+  {
+    add(counters.totalLatency, start - submitTime);
+    updateMax(counters.maxLatency, start - submitTime);
+  }
+
+  updateMax(counters.queueHighWater, worker.tasks.size() + worker.mailbox.size());
+
+  task();
+  task = Task{};
+  worker.arena.reset();
+
+  add(counters.busyTime, now() - start);
+  add(counters.tasksExecuted, 1);
+}
+
+/**
+ * @brief Puts a task to the background queue and wakes up a thread that
+ * is able to execute it
+ */
+void ThreadPool::submitBackground(Task && task)
+{
+  stamp(task);
+
+  while (!backgroundTasks.tryPush(std::move(task)))
+  {
+    std::this_thread::yield();
+  }
+
+  if (backgroundThreads.empty())
+  {
+    wakeWorkers(1);
+
+    return;
+  }
+
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  if (parkedBackgroundWorkers != 0)
+  {
+    {
+      std::lock_guard<std::mutex> lock{parkingMutex};
+    }
+
+    backgroundCondition.notify_one();
+  }
+}
+
+/**
+ * @brief Takes a background task unless there are threads reserved for them
+ */
+bool ThreadPool::tryPopBackgroundTask(Task & task)
+{
+  return backgroundThreads.empty() && backgroundTasks.tryPop(task);
+}
+
+/**
+ * @brief Takes a task from the shared queue
+ */
+bool ThreadPool::tryPopTask(Task & task)
+{
+  return tasks.tryPop(task);
+}
+
+/**
+ * @brief Takes a task from a mailbox of a given worker
+ */
+bool ThreadPool::tryPopMail(Task & task, std::size_t workerIndex)
+{
+  return workers[workerIndex]->mailbox.tryPop(task);
+}
+
+/**
+ * @brief Takes a member of a team addressed to a given worker
+ */
+bool ThreadPool::tryTakeTeamTask(Task & task, Worker & worker)
+{
+  if (!worker.teamTaskReady.load(std::memory_order_acquire))
+  {
+    return false;
+  }
+
+  task = std::move(worker.teamTask);
+  worker.teamTaskReady.store(false, std::memory_order_relaxed);
+  worker.teamTaskClaimed.store(false, std::memory_order_release);
+
+  return true;
+}
+
+/**
+ * @brief Tries to steal a task from other workers starting from a random one.
+ * Workers prefer victims from their own NUMA node
+ */
+bool ThreadPool::tryStealTask(Task & task, std::size_t thiefIndex,
+                              std::uint32_t & randomState)
+{
+  const auto count = workers.size();
+  const auto first = nextRandom(randomState) % count;
+  // On NUMA machines the first pass looks only at the thief's own node
+  const auto preferNode = thiefIndex < count && topology.getNodesCount() > 1;
+  const std::size_t passes = preferNode ? 2 : 1;
+
+  for (std::size_t pass = 0; pass < passes; ++pass)
+  {
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      const auto victim = (first + i) % count;
+
+      if (victim == thiefIndex)
+      {
+        continue;
+      }
+
+      if (preferNode &&
+          (workers[victim]->cpu.node == workers[thiefIndex]->cpu.node) != (pass == 0))
+      {
+        continue;
+      }
+
+      if (workers[victim]->tasks.steal(task))
+      {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+/**
+ * @brief Looks for a member of a team, then for a task in own deque and
+ * mailbox, then in the shared queue and then in other workers' deques
+ * @param takeOthersMail - also take tasks addressed to other workers
+ */
+bool ThreadPool::findTask(Task & task, std::size_t workerIndex, bool takeOthersMail)
+{
+  auto & worker = *workers[workerIndex];
+
+  if (tryTakeTeamTask(task, worker) ||
+      worker.tasks.pop(task) ||
+      tryPopMail(task, workerIndex) ||
+      tryPopTask(task))
+  {
+    return true;
+  }
+
+  if (tryStealTask(task, workerIndex, worker.randomState) ||
+      (takeOthersMail && tryTakeMail(task, workerIndex)))
+  {
+    if (metricsEnabled.load(std::memory_order_relaxed))
+    {
+      add(worker.counters.steals, 1);
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+/**
+ * @brief Takes a task addressed to some other worker
+ * @param thiefIndex - index of a worker that takes the task
+ */
+bool ThreadPool::tryTakeMail(Task & task, std::size_t thiefIndex)
+{
+  for (std::size_t i = 0; i < workers.size(); ++i)
+  {
+    if (i != thiefIndex && tryPopMail(task, i))
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * @brief Executes one pending task on the calling thread. Threads outside
+ * of the pool take tasks from the shared queue or steal them from workers
+ * @return False if there was nothing to execute
+ */
+bool ThreadPool::runPendingTask()
+{
+  thread_local std::uint32_t randomState = 2463534242u;
+
+  Task task;
+  // A waiting thread must not leave anything behind, including tasks that
+  // are addressed to busy workers
+  const auto found = currentPool == this ?
+        findTask(task, currentWorker, true) :
+        tryPopTask(task) || tryStealTask(task, workers.size(), randomState) ||
+        tryTakeMail(task, workers.size());
+
+  if (found)
+  {
+    task();
+  }
+
+  return found;
+}
+
+/**
+ * @brief Checks if there is any task waiting to be executed
+ */
+bool ThreadPool::hasPendingTasks() const noexcept
+{
+  if (!tasks.empty())
+  {
+    return true;
+  }
+
+  for (const auto & worker : workers)
+  {
+    if (!worker->tasks.empty() || !worker->mailbox.empty())
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * @brief Wakes up a given number of parked workers if there are any
+ */
+void ThreadPool::wakeWorkers(std::size_t count)
+{
+  // Make sure that the new tasks are visible before checking for sleepers
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  // Only pay for a notification when somebody is actually sleeping
+  if (parkedWorkers == 0)
+  {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock{parkingMutex};
+  }
+
+  if (count == 1)
+  {
+    parkingCondition.notify_one();
+  }
+  else
+  {
+    parkingCondition.notify_all();
+  }
+}
+
+/**
+ * @brief Puts the current worker to sleep until new tasks arrive
+ */
+void ThreadPool::park(std::size_t workerIndex)
+{
+  auto & worker = *workers[workerIndex];
+  std::unique_lock<std::mutex> lock{parkingMutex};
+
+  const auto start = metricsEnabled.load(std::memory_order_relaxed) ? now() : 0;
+
+  ++parkedWorkers;
+  worker.parked = true;
+  parkingCondition.wait(lock, [this, & worker]
+  {
+    return done || worker.teamTaskReady || hasPendingTasks() ||
+           (backgroundThreads.empty() && !backgroundTasks.empty());
+  });
+  worker.parked = false;
+  --parkedWorkers;
+
+  if (start != 0)
+  {
+    add(worker.counters.parkedTime, now() - start);
+  }
+}
+
+/**
+ * @brief Puts a deactivated worker to sleep until it's activated again or
+ * gets a task addressed to it
+ */
+void ThreadPool::parkInactive(std::size_t workerIndex)
+{
+  auto & worker = *workers[workerIndex];
+  std::unique_lock<std::mutex> lock{parkingMutex};
+
+  worker.parked = true;
+  inactiveCondition.wait(lock, [this, & worker, workerIndex]
+  {
+    return done || workerIndex < activeWorkers || worker.teamTaskReady ||
+           !worker.tasks.empty() || !worker.mailbox.empty();
+  });
+  worker.parked = false;
+}
+
+/**
+ * @brief Main loop of a worker thread. Polls for tasks for a while when
+ * there's nothing to do and then parks
+ */
+void ThreadPool::workerLoop(std::size_t workerIndex)
+{
+  using Clock = std::chrono::steady_clock;
+
+  currentPool = this;
+  currentWorker = workerIndex;
+
+  if (options.pinWorkers && workers[workerIndex]->pinnable)
+  {
+    Topology::pinCurrentThread(workers[workerIndex]->cpu.id);
+  }
+
+  auto & worker = *workers[workerIndex];
+  Task task;
+
+  while (true)
+  {
+    if (workerIndex >= activeWorkers.load(std::memory_order_relaxed))
+    {
+      // Deactivated workers only finish the work addressed to them
+      if (tryTakeTeamTask(task, worker) || worker.tasks.pop(task) ||
+          tryPopMail(task, workerIndex))
+      {
+        execute(task, worker);
+      }
+      else if (done)
+      {
+        break;
+      }
+      else
+      {
+        // This worker may have been woken up for shared work just before
+        // deactivation, pass it on
+        if (hasPendingTasks())
+        {
+          wakeWorkers(1);
+        }
+
+        parkInactive(workerIndex);
+      }
+
+      continue;
+    }
+
+    if (findTask(task, workerIndex, false))
+    {
+      execute(task, worker);
+
+      continue;
+    }
+
+    const auto spinStart = Clock::now();
+    const auto spinEnd = spinStart + options.spinDuration;
+    bool found = false;
+
+    while (!found && Clock::now() < spinEnd)
+    {
+      std::this_thread::yield();
+
+      found = findTask(task, workerIndex, false);
+    }
+
+    // Tasks addressed to other workers are taken only if those workers
+    // haven't picked them up while this one was spinning. The same goes for
+    // background tasks
+    found = found || findTask(task, workerIndex, true) || tryPopBackgroundTask(task);
+
+    if (metricsEnabled.load(std::memory_order_relaxed))
+    {
+      const auto idleTime = Clock::now() - spinStart;
+
+      add(worker.counters.idleTime, static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(idleTime).count()));
+    }
+
+    if (found)
+    {
+      execute(task, worker);
+    }
+    else if (done)
+    {
+      break;
+    }
+    else
+    {
+      park(workerIndex);
+    }
+  }
+}
+
+/**
+ * @brief Main loop of a thread reserved for background tasks
+ */
+void ThreadPool::backgroundLoop()
+{
+  Task task;
+
+  while (true)
+  {
+    if (backgroundTasks.tryPop(task))
+    {
+      task();
+      task = Task{};
+
+      continue;
+    }
+
+    if (done)
+    {
+      break;
+    }
+
+    std::unique_lock<std::mutex> lock{parkingMutex};
+
+    ++parkedBackgroundWorkers;
+    backgroundCondition.wait(lock, [this] { return done || !backgroundTasks.empty(); });
+    --parkedBackgroundWorkers;
+  }
+}
+
+/**
+ * @brief Sets how many workers take shared work
+ */
+void ThreadPool::setActiveWorkersCount(std::size_t count)
+{
+  count = std::max<std::size_t>(1, std::min(count, workers.size()));
+
+  {
+    std::lock_guard<std::mutex> lock{parkingMutex};
+
+    activeWorkers = count;
+  }
+
+  // Activated workers leave their inactive sleep, deactivated ones notice
+  // the change the next time they look for work
+  inactiveCondition.notify_all();
+  parkingCondition.notify_all();
+}
+
+/**
+ * @brief Hands a range job out to helpers, takes part in it and waits for
+ * it to finish
+ * @param affine - whether every helper starts with its own partition
+ */
+void ThreadPool::runRangeJob(RangeJob & job, std::size_t helpers, bool affine)
+{
+  assert(!isTeamMember());
+
+  if (affine)
+  {
+    for (std::size_t i = 0; i < helpers; ++i)
+    {
+      submitTo(i, Task{[& job, i]
+      {
+        job.run(i);
+        job.latch.countDown();
+      }});
+    }
+  }
+  else
+  {
+    std::array<Task, RangeJob::maxPartitions> helperTasks;
+
+    for (std::size_t i = 0; i < helpers; ++i)
+    {
+      helperTasks[i] = Task{[& job]
+      {
+        job.run(0);
+        job.latch.countDown();
+      }};
+    }
+
+    submitBatch(helperTasks.data(), helpers);
+  }
+
+  // The calling thread owns the last partition
+  job.run(job.partitionsCount - 1);
+  helpUntil([& job] { return job.latch.isReady(); });
+
+  if (job.failed.load(std::memory_order_relaxed))
+  {
+    std::rethrow_exception(job.exception);
+  }
+
+  if (job.startTime != 0)
+  {
+    recordRangeJob(job);
+  }
+}
+
+/**
+ * @brief Feeds efficiency of a finished parallelFor call to the controller
+ */
+void ThreadPool::recordRangeJob(const RangeJob & job)
+{
+  recordParallelRegion(job.workTime.load(std::memory_order_relaxed),
+                       now() - job.startTime, job.participants);
+}
+
+/**
+ * @brief Adds one worker when the participants of parallel regions are
+ * mostly busy and removes one when they mostly wait
+ * @param workTime - total time the participants spent on actual work
+ * @param wallTime - duration of the region
+ * @param participants - number of threads that could take part in it
+ */
+void ThreadPool::recordParallelRegion(std::uint64_t workTime, std::uint64_t wallTime,
+                                      std::size_t participants)
+{
+  // Concurrent regions skip the sample rather than wait for each other
+  std::unique_lock<std::mutex> lock{elasticity.mutex, std::try_to_lock};
+
+  if (!lock.owns_lock() || wallTime == 0)
+  {
+    return;
+  }
+
+  const auto efficiency = static_cast<double>(workTime) /
+                          (static_cast<double>(wallTime) * participants);
+
+  elasticity.efficiency += (efficiency - elasticity.efficiency) * 0.2;
+
+  if (++elasticity.samples < Elasticity::window)
+  {
+    return;
+  }
+
+  elasticity.samples = 0;
+
+  const auto active = getActiveWorkersCount();
+
+  if (elasticity.efficiency > Elasticity::growThreshold && active < workers.size())
+  {
+    setActiveWorkersCount(active + 1);
+  }
+  else if (elasticity.efficiency < Elasticity::shrinkThreshold && active > 1)
+  {
+    setActiveWorkersCount(active - 1);
+  }
+}
+
+/**
+ * @brief Returns the biggest team that can be started from the calling thread
+ */
+std::size_t ThreadPool::getMaxTeamSize() const noexcept
+{
+  return currentPool == this ? workers.size() : workers.size() + 1;
+}
+
+/**
+ * @brief Chooses a worker for a member of a team. Members go to different
+ * workers, skipping the calling one
+ */
+std::size_t ThreadPool::getTeamWorker(std::size_t member) const noexcept
+{
+  return currentPool == this ? (currentWorker + member) % workers.size() : member - 1;
+}
+
+/**
+ * @brief Checks if the calling thread runs a member of a team
+ */
+bool ThreadPool::isTeamMember() noexcept
+{
+  return teamMember;
+}
+
+ThreadPool::TeamMemberScope::TeamMemberScope() noexcept
+  : wasTeamMember(teamMember)
+{
+  teamMember = true;
+}
+
+ThreadPool::TeamMemberScope::~TeamMemberScope()
+{
+  teamMember = wasTeamMember;
+}
+
+/**
+ * @brief Returns scratch arena of the calling thread
+ */
+Arena & ThreadPool::getScratchArena() noexcept
+{
+  if (currentPool == this)
+  {
+    return workers[currentWorker]->arena;
+  }
+
+  thread_local Arena arena;
+
+  return arena;
+}
+
+/**
+ * @brief Returns statistics collected since the start or the last reset
+ */
+ThreadPool::Metrics ThreadPool::getMetrics() const
+{
+  using std::chrono::nanoseconds;
+
+  Metrics metrics;
+
+  for (const auto & worker : workers)
+  {
+    const auto & counters = worker->counters;
+    WorkerMetrics workerMetrics;
+
+    workerMetrics.tasksExecuted = counters.tasksExecuted.load(std::memory_order_relaxed);
+    workerMetrics.steals = counters.steals.load(std::memory_order_relaxed);
+    workerMetrics.busyTime = nanoseconds(counters.busyTime.load(std::memory_order_relaxed));
+    workerMetrics.idleTime = nanoseconds(counters.idleTime.load(std::memory_order_relaxed));
+    workerMetrics.parkedTime = nanoseconds(counters.parkedTime.load(std::memory_order_relaxed));
+    workerMetrics.queueHighWater = counters.queueHighWater.load(std::memory_order_relaxed);
+    workerMetrics.totalLatency = nanoseconds(counters.totalLatency.load(std::memory_order_relaxed));
+    workerMetrics.maxLatency = nanoseconds(counters.maxLatency.load(std::memory_order_relaxed));
+
+    metrics.workers.push_back(workerMetrics);
+  }
+
+  metrics.sharedQueueHighWater = sharedQueueHighWater.load(std::memory_order_relaxed);
+
+  return metrics;
+}
+
+/**
+ * @brief Resets collected statistics
+ */
+void ThreadPool::resetMetrics() noexcept
+{
+  for (auto & worker : workers)
+  {
+    auto & counters = worker->counters;
+
+    for (auto counter : { & counters.tasksExecuted, & counters.steals,
+                          & counters.busyTime, & counters.idleTime,
+                          & counters.parkedTime, & counters.queueHighWater,
+                          & counters.totalLatency, & counters.maxLatency })
+    {
+      counter->store(0, std::memory_order_relaxed);
+    }
+  }
+
+  sharedQueueHighWater = 0;
+}
+}
@@ -0,0 +1,315 @@
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+#include "Topology.hpp"
+
+#ifdef __linux__
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace ABM
+{
+namespace
+{
+/**
+ * @brief Reads the first line of a sysfs file
+ */
+bool readLine(const std::string & path, std::string & line)
+{
+  std::ifstream file{path};
+
+  return static_cast<bool>(std::getline(file, line));
+}
+
+/**
+ * @brief Reads a single number from a sysfs file
+ */
+std::size_t readNumber(const std::string & path, std::size_t defaultValue)
+{
+  std::ifstream file{path};
+  std::size_t value = defaultValue;
+
+  file >> value;
+
+  return file ? value : defaultValue;
+}
+
+/**
+ * @brief Finds NUMA node of a CPU from the "nodeN" entry of its directory
+ */
+std::size_t readNode(const std::string & cpuPath)
+{
+  std::size_t node = 0;
+
+#ifdef __linux__
+  if (auto directory = opendir(cpuPath.c_str()))
+  {
+    while (auto entry = readdir(directory))
+    {
+      const std::string name{entry->d_name};
+
+      if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+          std::all_of(name.begin() + 4, name.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; }))
+      {
+        node = std::stoul(name.substr(4));
+        break;
+      }
+    }
+
+    closedir(directory);
+  }
+#endif
+
+  return node;
+}
+
+/**
+ * @brief Takes CPUs from all of the nodes in turn until there are enough
+ * of them or the nodes run out of CPUs
+ * @param nodes - CPUs of every node
+ * @param count - number of CPUs needed
+ * @param selected - CPUs taken so far
+ */
+void takeFromNodesInTurn(const std::vector<std::vector<Topology::Cpu>> & nodes,
+                         std::size_t count, std::vector<Topology::Cpu> & selected)
+{
+  for (std::size_t i = 0; selected.size() < count; ++i)
+  {
+    auto taken = false;
+
+    for (const auto & node : nodes)
+    {
+      if (i < node.size() && selected.size() < count)
+      {
+        selected.push_back(node[i]);
+        taken = true;
+      }
+    }
+
+    if (!taken)
+    {
+      return;
+    }
+  }
+}
+}
+
+/**
+ * @brief Parses kernel's CPU list format
+ * @param list - comma separated list of CPUs and ranges of CPUs
+ * @return Vector of CPU ids
+ */
+std::vector<std::size_t> Topology::parseCpuList(const std::string & list)
+{
+  std::vector<std::size_t> ids;
+  std::size_t position = 0;
+
+  while (position < list.size())
+  {
+    auto end = list.find(',', position);
+
+    if (end == std::string::npos)
+    {
+      end = list.size();
+    }
+
+    const auto item = list.substr(position, end - position);
+    const auto dash = item.find('-');
+
+    if (!item.empty() && std::isdigit(static_cast<unsigned char>(item.front())))
+    {
+      const auto first = std::stoul(item);
+      const auto last = dash != std::string::npos ? std::stoul(item.substr(dash + 1)) : first;
+
+      for (auto id = first; id <= last; ++id)
+      {
+        ids.push_back(id);
+      }
+    }
+
+    position = end + 1;
+  }
+
+  return ids;
+}
+
+/**
+ * @brief Reads topology from sysfs
+ * @param root - path to the CPU devices directory
+ */
+Topology Topology::detect(const std::string & root)
+{
+  Topology topology;
+  std::string online;
+
+  if (readLine(root + "/online", online))
+  {
+    for (const auto id : parseCpuList(online))
+    {
+      const auto cpuPath = root + "/cpu" + std::to_string(id);
+      std::string siblings;
+      Cpu cpu;
+
+      cpu.id = id;
+      cpu.core = readNumber(cpuPath + "/topology/core_id", id);
+      cpu.package = readNumber(cpuPath + "/topology/physical_package_id", 0);
+      cpu.node = readNode(cpuPath);
+
+      if (readLine(cpuPath + "/topology/thread_siblings_list", siblings))
+      {
+        const auto siblingIds = parseCpuList(siblings);
+
+        cpu.primaryThread = siblingIds.empty() || siblingIds.front() == id;
+      }
+
+      topology.cpus.push_back(cpu);
+    }
+  }
+
+  if (topology.cpus.empty())
+  {
+    const auto count = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (std::size_t id = 0; id < count; ++id)
+    {
+      Cpu cpu;
+
+      cpu.id = id;
+      cpu.core = id;
+      topology.cpus.push_back(cpu);
+    }
+  }
+
+  for (const auto & cpu : topology.cpus)
+  {
+    topology.nodesCount = std::max(topology.nodesCount, cpu.node + 1);
+  }
+
+  return topology;
+}
+
+/**
+ * @brief Returns CPUs the calling thread is allowed to run on, so threads
+ * are not pinned to CPUs excluded by taskset or cgroups
+ */
+std::vector<std::size_t> Topology::getAllowedCpus()
+{
+  std::vector<std::size_t> ids;
+
+#ifdef __linux__
+  cpu_set_t set;
+
+  CPU_ZERO(& set);
+
+  if (sched_getaffinity(0, sizeof(set), & set) == 0)
+  {
+    for (std::size_t id = 0; id < CPU_SETSIZE; ++id)
+    {
+      if (CPU_ISSET(id, & set))
+      {
+        ids.push_back(id);
+      }
+    }
+  }
+#endif
+
+  return ids;
+}
+
+/**
+ * @brief Pins the calling thread to a given logical CPU
+ * @param cpu - id of a CPU
+ */
+bool Topology::pinCurrentThread(std::size_t cpu) noexcept
+{
+#ifdef __linux__
+  // CPUs beyond the fixed size set can't be expressed by it
+  if (cpu >= CPU_SETSIZE)
+  {
+    return false;
+  }
+
+  cpu_set_t set;
+
+  CPU_ZERO(& set);
+  CPU_SET(cpu, & set);
+
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), & set) == 0;
+#else
+  (void)cpu;
+
+  return false;
+#endif
+}
+
+/**
+ * @brief Chooses CPUs for a given number of threads
+ * @param count - number of threads
+ * @param skipSmtSiblings - use only one hardware thread of each core
+ * @param allowedCpus - CPUs that can be used, all of them if empty
+ */
+std::vector<Topology::Cpu> Topology::selectCpus(std::size_t count, bool skipSmtSiblings,
+                                                const std::vector<std::size_t> & allowedCpus) const
+{
+  std::vector<Cpu> candidates;
+
+  std::copy_if(cpus.begin(), cpus.end(), std::back_inserter(candidates),
+               [& allowedCpus](const Cpu & cpu)
+  {
+    return allowedCpus.empty() ||
+           std::find(allowedCpus.begin(), allowedCpus.end(), cpu.id) != allowedCpus.end();
+  });
+
+  // The mask may refer to other ids than the topology, e.g. a flat one
+  if (candidates.empty())
+  {
+    candidates = cpus;
+  }
+
+  std::stable_sort(candidates.begin(), candidates.end(), [](const Cpu & left, const Cpu & right)
+  {
+    if (left.package != right.package)
+    {
+      return left.package < right.package;
+    }
+
+    return left.core < right.core;
+  });
+
+  std::vector<std::vector<Cpu>> primaryThreads(nodesCount);
+  std::vector<std::vector<Cpu>> siblings(nodesCount);
+
+  for (const auto & cpu : candidates)
+  {
+    (cpu.primaryThread ? primaryThreads : siblings)[cpu.node].push_back(cpu);
+  }
+
+  std::vector<Cpu> selected;
+
+  takeFromNodesInTurn(primaryThreads, count, selected);
+
+  // If only siblings are allowed, they are the only threads of their cores
+  if (!skipSmtSiblings || selected.empty())
+  {
+    takeFromNodesInTurn(siblings, count, selected);
+  }
+
+  std::stable_sort(selected.begin(), selected.end(), [](const Cpu & left, const Cpu & right)
+  {
+    if (left.node != right.node)
+    {
+      return left.node < right.node;
+    }
+
+    // SMT siblings go after primary threads of all cores of the node
+    return left.primaryThread && !right.primaryThread;
+  });
+
+  return selected;
+}
+}
@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <cassert>
+
+#include "Tuner.hpp"
+
+namespace ABM
+{
+namespace
+{
+// Weight of a new measurement in smoothed values
+const double smoothing = 0.25;
+// Parallel execution has to be at least this much faster to be chosen
+const double parallelAdvantage = 0.9;
+// Minimum number of chunks per thread, so threads can balance the load
+const std::size_t chunksPerThread = 4;
+
+/**
+ * @brief Adds a new measurement to a smoothed value
+ */
+void smooth(double & value, double measurement, bool measured)
+{
+  value = measured ? value + (measurement - value) * smoothing : measurement;
+}
+}
+
+/**
+ * @brief C-tor
+ * @param reevaluationPeriod - number of executions of a system after which
+ * the option that is not chosen is tried again
+ * @param chunkDuration - desired duration of a chunk of a parallel execution
+ */
+Tuner::Tuner(std::size_t reevaluationPeriod, std::chrono::nanoseconds chunkDuration)
+  : reevaluationPeriod(std::max<std::size_t>(reevaluationPeriod, 2)),
+    chunkDuration(chunkDuration)
+{
+}
+
+/**
+ * @brief Registers a system
+ * @return Index of the system
+ */
+std::size_t Tuner::addSystem(const std::string & name)
+{
+  entries.emplace_back();
+  entries.back().name = name;
+
+  return entries.size() - 1;
+}
+
+/**
+ * @brief Chooses how to execute a system. Serial execution is measured
+ * first, then parallel one, after that the faster of them is used
+ */
+Tuner::Decision Tuner::decide(std::size_t system, std::size_t agentsCount,
+                              std::size_t participants)
+{
+  assert(system < entries.size());
+
+  auto & entry = entries[system];
+  Decision decision;
+
+  entry.participants = std::max<std::size_t>(participants, 1);
+  ++entry.executions;
+
+  if (agentsCount == 0 || entry.participants == 1 || !entry.serialMeasured)
+  {
+    decision.parallel = false;
+  }
+  else if (!entry.parallelMeasured)
+  {
+    decision.parallel = true;
+  }
+  else
+  {
+    const auto serialTime = entry.agentCost * agentsCount;
+    const auto parallelTime = entry.parallelOverhead + serialTime / entry.participants;
+
+    decision.parallel = parallelTime < serialTime * parallelAdvantage;
+
+    entry.decision.parallel = decision.parallel;
+
+    // Try the other option once in a while
+    if (entry.executions % reevaluationPeriod == 0)
+    {
+      decision.parallel = !decision.parallel;
+    }
+  }
+
+  if (decision.parallel)
+  {
+    decision.grain = calculateGrain(entry, agentsCount);
+    entry.decision.grain = decision.grain;
+  }
+
+  return decision;
+}
+
+/**
+ * @brief Reports duration of an execution made according to a decision
+ */
+void Tuner::record(std::size_t system, const Decision & decision,
+                   std::size_t agentsCount, std::chrono::nanoseconds duration)
+{
+  assert(system < entries.size());
+
+  if (agentsCount == 0)
+  {
+    return;
+  }
+
+  auto & entry = entries[system];
+  const auto time = static_cast<double>(duration.count());
+
+  if (!decision.parallel)
+  {
+    smooth(entry.agentCost, time / agentsCount, entry.serialMeasured);
+    entry.serialMeasured = true;
+  }
+  else
+  {
+    const auto idealTime = entry.agentCost * agentsCount / entry.participants;
+
+    smooth(entry.parallelOverhead, std::max(time - idealTime, 0.), entry.parallelMeasured);
+    entry.parallelMeasured = true;
+  }
+}
+
+/**
+ * @brief Returns current decisions and measurements, one line per system
+ */
+std::string Tuner::getReport() const
+{
+  std::string report;
+
+  for (const auto & entry : entries)
+  {
+    report += "\n" + entry.name + ": " +
+              (entry.decision.parallel ? "parallel, grain " +
+                                         std::to_string(entry.decision.grain) : "serial") +
+              ", " + std::to_string(static_cast<int>(entry.agentCost)) + " ns/agent, " +
+              "overhead " + std::to_string(static_cast<int>(entry.parallelOverhead / 1000)) +
+              " us";
+  }
+
+  return report;
+}
+
+/**
+ * @brief Chooses a grain that makes chunks long enough to hide the cost of
+ * taking them, but leaves enough chunks for balancing the load
+ */
+std::size_t Tuner::calculateGrain(const Entry & entry, std::size_t agentsCount) const
+{
+  const auto byCost = entry.agentCost > 0 ?
+        static_cast<std::size_t>(chunkDuration.count() / entry.agentCost) : agentsCount;
+  const auto byBalance = (agentsCount + entry.participants * chunksPerThread - 1) /
+                         (entry.participants * chunksPerThread);
+
+  return std::max<std::size_t>(std::min(byCost, byBalance), 1);
+}
+}
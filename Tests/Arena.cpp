@@ -0,0 +1,70 @@
+#include "catch.hpp"
+
+#include <cstdint>
+#include <numeric>
+
+#include "Arena.hpp"
+#include "ThreadPool.hpp"
+
+using namespace ABM;
+
+TEST_CASE("Arena")
+{
+  Arena arena{1024};
+
+  SECTION("Allocations are aligned and don't overlap")
+  {
+    const auto first = reinterpret_cast<std::uintptr_t>(arena.allocate(3, 1));
+    const auto second = reinterpret_cast<std::uintptr_t>(arena.allocate(sizeof(double),
+                                                                        alignof(double)));
+
+    REQUIRE(second % alignof(double) == 0);
+    REQUIRE(second >= first + 3);
+  }
+
+  SECTION("Memory is reused after rewinding")
+  {
+    const auto first = arena.allocate(100);
+
+    arena.reset();
+
+    REQUIRE(arena.allocate(100) == first);
+
+    {
+      const Arena::Scope scope{arena};
+
+      arena.allocate(4096);
+    }
+
+    const auto capacity = arena.getCapacity();
+
+    {
+      const Arena::Scope scope{arena};
+
+      arena.allocate(4096);
+    }
+
+    REQUIRE(arena.getCapacity() == capacity);
+  }
+
+  SECTION("Vectors grow across blocks")
+  {
+    ArenaVector<std::size_t> values{arena};
+
+    for (std::size_t i = 0; i < 1000; ++i)
+    {
+      values.push_back(i);
+    }
+
+    REQUIRE(std::accumulate(values.begin(), values.end(), std::size_t{0}) == 499500u);
+  }
+
+  SECTION("Workers have their own arenas")
+  {
+    ThreadPool threadPool{2};
+    auto & callerArena = threadPool.getScratchArena();
+    auto workerArena = threadPool.addTask([& threadPool] { return & threadPool.getScratchArena(); });
+
+    REQUIRE(workerArena.get() != & callerArena);
+  }
+}
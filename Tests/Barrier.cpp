@@ -0,0 +1,89 @@
+#include "catch.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "Barrier.hpp"
+#include "ThreadPool.hpp"
+
+using namespace ABM;
+
+TEST_CASE("Barrier")
+{
+  const std::size_t threadsCount = 4;
+  const int phases = 1000;
+
+  SECTION("No thread enters a phase before all of them finish the previous one")
+  {
+    // No spinning, so threads go to sleep on every phase
+    Barrier barrier{threadsCount, std::chrono::microseconds{0}};
+    std::atomic<int> arrivals{0};
+    std::atomic<int> lastArrivals{0};
+    std::atomic<int> violations{0};
+    std::vector<std::thread> threads;
+
+    for (std::size_t i = 0; i < threadsCount; ++i)
+    {
+      threads.emplace_back([&]
+      {
+        for (int phase = 0; phase < phases; ++phase)
+        {
+          ++arrivals;
+
+          if (barrier.arriveAndWait())
+          {
+            ++lastArrivals;
+          }
+
+          if (arrivals < static_cast<int>(threadsCount) * (phase + 1))
+          {
+            ++violations;
+          }
+
+          // Nobody may start counting the next phase before everybody has
+          // checked this one
+          barrier.arriveAndWait();
+        }
+      });
+    }
+
+    for (auto & thread : threads)
+    {
+      thread.join();
+    }
+
+    REQUIRE(violations == 0);
+    REQUIRE(lastArrivals == phases);
+  }
+
+  SECTION("Team members of a pool can synchronise through a barrier")
+  {
+    ThreadPool threadPool{threadsCount};
+    const auto teamSize = threadPool.getMaxTeamSize();
+    Barrier barrier{teamSize};
+    std::vector<int> values(teamSize, 0);
+    std::atomic<int> violations{0};
+
+    REQUIRE(teamSize == threadsCount + 1);
+
+    threadPool.runTeam(teamSize, [&](std::size_t member)
+    {
+      for (int phase = 1; phase <= 100; ++phase)
+      {
+        values[member] = phase;
+        barrier.arriveAndWait();
+
+        // Read the neighbour's value written in the same phase
+        if (values[(member + 1) % teamSize] != phase)
+        {
+          ++violations;
+        }
+
+        barrier.arriveAndWait();
+      }
+    });
+
+    REQUIRE(violations == 0);
+  }
+}
@@ -0,0 +1,86 @@
+#include "catch.hpp"
+
+#include <stdexcept>
+#include <vector>
+
+#include "Coroutine.hpp"
+
+// Coroutines are available only in C++20 builds
+#if defined(__cpp_impl_coroutine)
+
+using namespace ABM;
+
+namespace
+{
+AsyncTask<int> square(ThreadPool & threadPool, int value)
+{
+  co_await threadPool.schedule();
+
+  co_return value * value;
+}
+
+AsyncTask<int> sumOfSquares(ThreadPool & threadPool, int count)
+{
+  std::vector<AsyncTask<int>> tasks;
+
+  for (int i = 0; i < count; ++i)
+  {
+    tasks.push_back(square(threadPool, i));
+  }
+
+  int sum = 0;
+
+  for (const auto value : co_await whenAll(std::move(tasks)))
+  {
+    sum += value;
+  }
+
+  co_return sum;
+}
+
+AsyncTask<> fail(ThreadPool & threadPool)
+{
+  co_await threadPool.schedule();
+
+  throw std::runtime_error("failed");
+}
+}
+
+TEST_CASE("Coroutines")
+{
+  ThreadPool threadPool{4};
+
+  SECTION("Awaited tasks deliver their results")
+  {
+    REQUIRE(syncWait(threadPool, square(threadPool, 7)) == 49);
+  }
+
+  SECTION("whenAll runs tasks on the pool and keeps their order")
+  {
+    REQUIRE(syncWait(threadPool, sumOfSquares(threadPool, 100)) == 328350);
+  }
+
+  SECTION("Exceptions reach the awaiting coroutine")
+  {
+    std::vector<AsyncTask<>> tasks;
+
+    tasks.push_back(fail(threadPool));
+
+    REQUIRE_THROWS_AS(syncWait(threadPool, whenAll(std::move(tasks))),
+                      const std::runtime_error &);
+  }
+
+  SECTION("Background scheduling resumes coroutines")
+  {
+    auto task = [](ThreadPool & threadPool) -> AsyncTask<bool>
+    {
+      co_await threadPool.scheduleBackground();
+
+      co_return true;
+    };
+
+    REQUIRE(syncWait(threadPool, task(threadPool)));
+  }
+}
+
+#endif
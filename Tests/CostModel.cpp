@@ -0,0 +1,74 @@
+#include "catch.hpp"
+
+#include <chrono>
+#include <vector>
+
+#include "CostModel.hpp"
+
+using namespace ABM;
+
+TEST_CASE("CostModel")
+{
+  using std::chrono::nanoseconds;
+
+  CostModel costModel{10};
+  std::vector<std::size_t> boundaries;
+
+  // Only the first half of elements has weight
+  costModel.resize(100, [](std::size_t first, std::size_t) { return first < 50 ? 10 : 0; });
+
+  SECTION("Unmeasured blocks are split by weight")
+  {
+    costModel.split(0, 100, 3, boundaries);
+
+    const std::vector<std::size_t> expected{ 0, 20, 30, 100 };
+
+    REQUIRE(boundaries == expected);
+  }
+
+  SECTION("Measured costs take precedence over weights")
+  {
+    // The last block turns out to be the most expensive one
+    for (std::size_t first = 0; first < 90; first += 10)
+    {
+      costModel.record(first, first + 10, nanoseconds{first < 50 ? 100 : 0});
+    }
+
+    costModel.record(90, 100, nanoseconds{900});
+    costModel.split(0, 100, 2, boundaries);
+
+    const std::vector<std::size_t> expected{ 0, 90, 100 };
+
+    REQUIRE(boundaries == expected);
+  }
+
+  SECTION("New blocks are estimated from measured cost of a unit of weight")
+  {
+    costModel.record(0, 100, nanoseconds{500});
+    costModel.resize(150, [](std::size_t first, std::size_t)
+    {
+      return first < 50 || first >= 100 ? 10 : 0;
+    });
+    costModel.split(0, 150, 3, boundaries);
+
+    // 100 ns per block everywhere but the empty blocks [50, 100)
+    const std::vector<std::size_t> expected{ 0, 30, 120, 150 };
+
+    REQUIRE(boundaries == expected);
+  }
+
+  SECTION("Measured costs follow changes of weights")
+  {
+    costModel.record(0, 100, nanoseconds{500});
+    // Agents move into the first block, which is four times as heavy now
+    costModel.resize(100, [](std::size_t first, std::size_t)
+    {
+      return first == 0 ? 40 : first < 50 ? 10 : 0;
+    });
+    costModel.split(0, 100, 2, boundaries);
+
+    const std::vector<std::size_t> expected{ 0, 10, 100 };
+
+    REQUIRE(boundaries == expected);
+  }
+}
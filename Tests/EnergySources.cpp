@@ -0,0 +1,44 @@
+#include "catch.hpp"
+
+#include "EnergySources.hpp"
+
+using namespace ABM;
+
+TEST_CASE("EnergySources")
+{
+  EnergySources sources;
+
+  sources.resize(37);
+
+  for (std::size_t i = 0; i < sources.size(); ++i)
+  {
+    sources.set(i, 100.f, static_cast<float>(i), 10.f + i, { 1.f * i, 2.f * i });
+  }
+
+  SECTION("Properties of a source are stored")
+  {
+    REQUIRE(sources.size() == 37u);
+    REQUIRE(sources.getCurrentLevel(5) == 5.f);
+    REQUIRE(sources.getMaxCapacity(5) == 100.f);
+    REQUIRE(sources.getRegenerationRate(5) == 15.f);
+    REQUIRE(sources.getPosition(5) == sf::Vector2f(5.f, 10.f));
+  }
+
+  SECTION("Regeneration is limited by capacity and affects only a given range")
+  {
+    sources.regenerate(1, 36, 2.f);
+
+    REQUIRE(sources.getCurrentLevel(0) == 0.f);
+    REQUIRE(sources.getCurrentLevel(1) == 1.f + 11.f * 2.f);
+    REQUIRE(sources.getCurrentLevel(20) == 20.f + 30.f * 2.f);
+    REQUIRE(sources.getCurrentLevel(30) == 100.f);
+    REQUIRE(sources.getCurrentLevel(35) == 100.f);
+    REQUIRE(sources.getCurrentLevel(36) == 36.f);
+  }
+
+  SECTION("Reset returns collected energy")
+  {
+    REQUIRE(sources.reset(7) == 7.f);
+    REQUIRE(sources.getCurrentLevel(7) == 0.f);
+  }
+}
@@ -0,0 +1,35 @@
+#include "catch.hpp"
+
+#include "FixedTimestep.hpp"
+
+using namespace ABM;
+
+TEST_CASE("FixedTimestep")
+{
+  FixedTimestep timestep{0.25f, 4};
+
+  SECTION("Time that is not enough for a tick is carried over")
+  {
+    REQUIRE(timestep.advance(0.1f) == 0u);
+    REQUIRE(timestep.advance(0.5f) == 2u);
+    REQUIRE(timestep.getInterpolation() == Approx(0.4f));
+  }
+
+  SECTION("Ticks per frame are limited and the rest of time is dropped")
+  {
+    REQUIRE(timestep.advance(2.1f) == 4u);
+    REQUIRE(timestep.getInterpolation() == Approx(0.4f));
+    REQUIRE(timestep.advance(0.f) == 0u);
+  }
+
+  SECTION("Nothing is simulated while paused")
+  {
+    timestep.setPaused(true);
+
+    REQUIRE(timestep.advance(1.f) == 0u);
+
+    timestep.setPaused(false);
+
+    REQUIRE(timestep.advance(0.25f) == 1u);
+  }
+}
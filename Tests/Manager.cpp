@@ -58,6 +58,28 @@ TEST_CASE("ComponentStorage")
     REQUIRE_FALSE(manager.isAlive(index));
   }
 
+  SECTION("Create a batch of agents")
+  {
+    manager.createIndex();
+
+    const auto first = manager.createIndexes(50);
+
+    REQUIRE(first == 1u);
+    REQUIRE(manager.getCapacity() >= 51u);
+
+    for (std::size_t index = first; index < first + 50; ++index)
+    {
+      REQUIRE(manager.isAlive(index));
+      REQUIRE_FALSE(manager.matchesSignature<Integral>(index));
+    }
+
+    REQUIRE(manager.createIndex() == 51u);
+
+    manager.refresh();
+
+    REQUIRE(manager.getAgentsCount() == 52u);
+  }
+
   SECTION("Attaching and removing components")
   {
     const auto index = manager.createIndex();
@@ -0,0 +1,96 @@
+#include "catch.hpp"
+
+#include <thread>
+#include <vector>
+
+#include "MpmcQueue.hpp"
+
+using namespace ABM;
+
+TEST_CASE("MpmcQueue")
+{
+  MpmcQueue<int> queue{8};
+  int value = 0;
+
+  SECTION("Elements come out in FIFO order")
+  {
+    for (int i = 0; i < 8; ++i)
+    {
+      REQUIRE(queue.tryPush(int{i}));
+    }
+
+    REQUIRE_FALSE(queue.tryPush(int{8}));
+    REQUIRE(queue.size() == 8u);
+
+    for (int i = 0; i < 8; ++i)
+    {
+      REQUIRE(queue.tryPop(value));
+      REQUIRE(value == i);
+    }
+
+    REQUIRE_FALSE(queue.tryPop(value));
+    REQUIRE(queue.empty());
+  }
+
+  SECTION("Batches are added only if they fit")
+  {
+    int batch[] = { 1, 2, 3, 4, 5 };
+
+    REQUIRE(queue.tryPushBatch(batch, 5));
+    REQUIRE_FALSE(queue.tryPushBatch(batch, 5));
+    REQUIRE(queue.tryPop(value));
+    REQUIRE(value == 1);
+    REQUIRE(queue.tryPushBatch(batch, 4));
+    REQUIRE(queue.size() == 8u);
+  }
+
+  SECTION("Concurrent producers and consumers")
+  {
+    MpmcQueue<int> sharedQueue{64};
+    std::atomic<long> sum{0};
+    std::vector<std::thread> threads;
+
+    for (int producer = 0; producer < 2; ++producer)
+    {
+      threads.emplace_back([& sharedQueue]
+      {
+        int batch[] = { 1, 1, 1, 1 };
+
+        for (int i = 0; i < 2500; ++i)
+        {
+          while (!sharedQueue.tryPushBatch(batch, 4))
+          {
+            std::this_thread::yield();
+          }
+        }
+      });
+    }
+
+    for (int consumer = 0; consumer < 2; ++consumer)
+    {
+      threads.emplace_back([& sharedQueue, & sum]
+      {
+        int element = 0;
+
+        while (sum < 20000)
+        {
+          if (sharedQueue.tryPop(element))
+          {
+            sum += element;
+          }
+          else
+          {
+            std::this_thread::yield();
+          }
+        }
+      });
+    }
+
+    for (auto & thread : threads)
+    {
+      thread.join();
+    }
+
+    REQUIRE(sum == 20000);
+  }
+}
@@ -0,0 +1,76 @@
+#include "catch.hpp"
+
+#include <vector>
+
+#include "Pipeline.hpp"
+
+using namespace ABM;
+
+namespace
+{
+using PipelineComponents = ComponentList<int, float, double>;
+using WithInt = Signature<int>;
+using WithFloat = Signature<float>;
+using PipelineSignatures = SignatureList<WithInt, WithFloat>;
+using PipelineSettings = Settings<PipelineComponents, PipelineSignatures>;
+using TestPipeline = Pipeline<PipelineSettings>;
+}
+
+TEST_CASE("Pipeline")
+{
+  Manager<PipelineSettings> manager;
+  TestPipeline pipeline{manager};
+
+  for (std::size_t i = 0; i < 10u; ++i)
+  {
+    const auto index = manager.createIndex();
+
+    manager.addComponent<int>(index);
+    manager.addComponent<float>(index);
+  }
+
+  manager.refresh();
+
+  SECTION("Systems are split where one reads other agents' data that another writes")
+  {
+    TestPipeline::Access writeInt;
+    TestPipeline::Access readOthersInt;
+    TestPipeline::Access writeFloat;
+
+    writeInt.writes = TestPipeline::components<int>();
+    readOthersInt.readsOthers = TestPipeline::components<int>();
+    readOthersInt.writes = TestPipeline::components<double>();
+    writeFloat.reads = TestPipeline::components<int, double>();
+    writeFloat.writes = TestPipeline::components<float>();
+
+    const auto first = pipeline.addSystem<WithInt>(writeInt, [](std::size_t) { });
+    const auto second = pipeline.addSystem<WithInt>(readOthersInt, [](std::size_t) { });
+    const auto third = pipeline.addSystem<WithFloat>(writeFloat, [](std::size_t) { });
+
+    REQUIRE(pipeline.getGroups().size() == 2u);
+    REQUIRE(pipeline.getGroupOf(first) == 0u);
+    REQUIRE(pipeline.getGroupOf(second) == 1u);
+    REQUIRE(pipeline.getGroupOf(third) == 1u);
+    REQUIRE(pipeline.getChunkSize(0, sizeof(int) * 100) == 100u);
+  }
+
+  SECTION("Fused systems process a chunk one after another")
+  {
+    std::vector<std::size_t> order;
+    TestPipeline::Access access;
+
+    access.writes = TestPipeline::components<int>();
+
+    pipeline.addSystem<WithInt>(access, [& order](std::size_t index) { order.push_back(index); });
+    pipeline.addSystem<WithFloat>(access, [& order](std::size_t index) { order.push_back(index + 100); });
+
+    REQUIRE(pipeline.getGroups().size() == 1u);
+
+    pipeline.runGroup(0, 0, 2);
+    pipeline.runGroup(0, 2, 4);
+
+    const std::vector<std::size_t> expected{ 0, 1, 100, 101, 2, 3, 102, 103 };
+
+    REQUIRE(order == expected);
+  }
+}
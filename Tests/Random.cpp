@@ -0,0 +1,58 @@
+#include "catch.hpp"
+
+#include <set>
+
+#include "Random.hpp"
+
+using namespace ABM;
+
+TEST_CASE("Random")
+{
+  SECTION("Philox matches known answers")
+  {
+    const Philox::Counter zeros{{ 0, 0, 0, 0 }};
+    const Philox::Counter ones{{ 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff }};
+    const Philox::Counter expectedForZeros{{ 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 }};
+    const Philox::Counter expectedForOnes{{ 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd }};
+
+    REQUIRE(Philox::generate(zeros, {{ 0, 0 }}) == expectedForZeros);
+    REQUIRE(Philox::generate(ones, {{ 0xffffffff, 0xffffffff }}) == expectedForOnes);
+  }
+
+  SECTION("The same stream yields the same values")
+  {
+    RandomStream first{42, RandomStream::Domain::AgentMovement, 7, 100};
+    RandomStream second{42, RandomStream::Domain::AgentMovement, 7, 100};
+
+    for (int i = 0; i < 10; ++i)
+    {
+      REQUIRE(first.next() == second.next());
+    }
+  }
+
+  SECTION("Streams of different entities, ticks and domains differ")
+  {
+    std::set<std::uint32_t> values;
+
+    values.insert(RandomStream{42, RandomStream::Domain::AgentMovement, 7, 100}.next());
+    values.insert(RandomStream{42, RandomStream::Domain::AgentMovement, 8, 100}.next());
+    values.insert(RandomStream{42, RandomStream::Domain::AgentMovement, 7, 101}.next());
+    values.insert(RandomStream{42, RandomStream::Domain::AgentCreation, 7, 100}.next());
+    values.insert(RandomStream{43, RandomStream::Domain::AgentMovement, 7, 100}.next());
+
+    REQUIRE(values.size() == 5u);
+  }
+
+  SECTION("Uniform values are in range")
+  {
+    RandomStream random{1, RandomStream::Domain::AgentCreation, 0, 0};
+
+    for (int i = 0; i < 1000; ++i)
+    {
+      const auto value = random.uniform(-2.f, 3.f);
+
+      REQUIRE(value >= -2.f);
+      REQUIRE(value < 3.f);
+    }
+  }
+}
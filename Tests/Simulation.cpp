@@ -0,0 +1,182 @@
+#include "catch.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Simulation.hpp"
+
+using namespace ABM;
+
+TEST_CASE("Simulation")
+{
+  SimulationOptions options;
+
+  options.worldSize = { 1000.f, 800.f };
+  options.maxAgentsNumber = 200;
+  options.maxSourcesNumber = 20;
+  options.threadsNumber = 2;
+  options.seeded = true;
+  options.seed = 1;
+
+  Simulation simulation{options};
+
+  REQUIRE(simulation.getEnergySources().size() == 20u);
+
+  for (int i = 0; i < 40; ++i)
+  {
+    simulation.tick(1.f / 60.f);
+  }
+
+  const auto & agentManager = simulation.getAgentManager();
+
+  REQUIRE(simulation.getTicksCount() == 40u);
+  REQUIRE(agentManager.getAgentsCount() == 200u);
+
+  SECTION("Agents stay in the world and are positioned for drawing")
+  {
+    std::size_t outside = 0;
+
+    agentManager.forAllMatching<Render>([& agentManager, & outside, & options](std::size_t index)
+    {
+      const auto & position = agentManager.getComponent<Orientation>(index).position;
+
+      if (position.x < 0 || position.x > options.worldSize.x ||
+          position.y < 0 || position.y > options.worldSize.y ||
+          agentManager.getComponent<Graphic>(index).position != position)
+      {
+        ++outside;
+      }
+    });
+
+    REQUIRE(outside == 0u);
+  }
+}
+
+TEST_CASE("Simulation with a seed")
+{
+  SimulationOptions options;
+
+  options.worldSize = { 1000.f, 800.f };
+  // Enough agents for spawning to be split between threads
+  options.maxAgentsNumber = 3000;
+  options.initialAgentsNumber = 2500;
+  options.maxSourcesNumber = 20;
+  options.seeded = true;
+  options.seed = 7;
+  options.threadsNumber = 1;
+
+  Simulation first{options};
+
+  options.threadsNumber = 3;
+
+  Simulation second{options};
+
+  REQUIRE(first.getAgentManager().getAgentsCount() == 2500u);
+
+  // Long enough for agents to reach sources and compete for them
+  for (int i = 0; i < 60; ++i)
+  {
+    first.tick(1.f / 10.f);
+    second.tick(1.f / 10.f);
+  }
+
+  SECTION("Evolves the world the same way regardless of the number of threads")
+  {
+    const auto & firstSources = first.getEnergySources();
+    const auto & secondSources = second.getEnergySources();
+    const auto & firstAgents = first.getAgentManager();
+    const auto & secondAgents = second.getAgentManager();
+
+    for (std::size_t i = 0; i < firstSources.size(); ++i)
+    {
+      REQUIRE(firstSources.getPosition(i) == secondSources.getPosition(i));
+      REQUIRE(firstSources.getMaxCapacity(i) == secondSources.getMaxCapacity(i));
+      REQUIRE(firstSources.getCurrentLevel(i) == secondSources.getCurrentLevel(i));
+    }
+
+    REQUIRE(firstAgents.getAgentsCount() == secondAgents.getAgentsCount());
+
+    for (std::size_t i = 0; i < firstAgents.getAgentsCount(); ++i)
+    {
+      REQUIRE(firstAgents.getComponent<Orientation>(i).position ==
+              secondAgents.getComponent<Orientation>(i).position);
+      REQUIRE(firstAgents.getComponent<Destination>(i).position ==
+              secondAgents.getComponent<Destination>(i).position);
+      REQUIRE(firstAgents.getComponent<Information>(i).value ==
+              secondAgents.getComponent<Information>(i).value);
+      REQUIRE(firstAgents.getComponent<Energy>(i).value ==
+              secondAgents.getComponent<Energy>(i).value);
+    }
+  }
+}
+
+TEST_CASE("Simulation update modes")
+{
+  SimulationOptions options;
+
+  options.worldSize = { 1000.f, 800.f };
+  options.maxAgentsNumber = 600;
+  options.initialAgentsNumber = 600;
+  options.maxSourcesNumber = 30;
+  options.threadsNumber = 4;
+  options.seeded = true;
+  options.seed = 11;
+
+  // One simulation per mode, in the order modes are switched
+  std::vector<std::unique_ptr<Simulation>> simulations;
+  const std::vector<std::string> names{ "tuned", "graph", "team", "fused" };
+
+  for (std::size_t mode = 0; mode < names.size(); ++mode)
+  {
+    simulations.push_back(std::make_unique<Simulation>(options));
+
+    for (std::size_t i = 0; i < mode; ++i)
+    {
+      simulations.back()->switchUpdateMode();
+    }
+
+    REQUIRE(simulations.back()->getUpdateModeName() == names[mode]);
+  }
+
+  for (int i = 0; i < 200; ++i)
+  {
+    for (auto & simulation : simulations)
+    {
+      simulation->tick(1.f / 10.f);
+    }
+  }
+
+  SECTION("Every mode evolves the world the same way")
+  {
+    const auto & expectedAgents = simulations.front()->getAgentManager();
+    const auto & expectedSources = simulations.front()->getEnergySources();
+
+    for (std::size_t mode = 1; mode < simulations.size(); ++mode)
+    {
+      INFO("Mode " << names[mode]);
+
+      const auto & agents = simulations[mode]->getAgentManager();
+      const auto & sources = simulations[mode]->getEnergySources();
+
+      REQUIRE(simulations[mode]->getTicksCount() == 200u);
+      REQUIRE(agents.getAgentsCount() == expectedAgents.getAgentsCount());
+
+      for (std::size_t i = 0; i < agents.getAgentsCount(); ++i)
+      {
+        REQUIRE(agents.getComponent<Identity>(i).id == expectedAgents.getComponent<Identity>(i).id);
+        REQUIRE(agents.getComponent<Orientation>(i).position ==
+                expectedAgents.getComponent<Orientation>(i).position);
+        REQUIRE(agents.getComponent<Energy>(i).value ==
+                expectedAgents.getComponent<Energy>(i).value);
+        REQUIRE(agents.getComponent<Information>(i).value ==
+                expectedAgents.getComponent<Information>(i).value);
+      }
+
+      for (std::size_t i = 0; i < sources.size(); ++i)
+      {
+        REQUIRE(sources.getCurrentLevel(i) == expectedSources.getCurrentLevel(i));
+      }
+    }
+  }
+}
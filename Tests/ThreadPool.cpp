@@ -0,0 +1,595 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+
+#include "Barrier.hpp"
+#include "ThreadPool.hpp"
+
+using namespace ABM;
+
+TEST_CASE("ThreadPool")
+{
+  ThreadPoolOptions options;
+
+  options.spinDuration = std::chrono::microseconds{0};
+
+  ThreadPool threadPool{4, options};
+
+  SECTION("Task results are delivered through futures")
+  {
+    auto result = threadPool.addTask([](int left, int right) { return left + right; }, 2, 3);
+
+    REQUIRE(result.get() == 5);
+  }
+
+  SECTION("Tasks with large captures are executed")
+  {
+    std::array<int, 64> values;
+
+    values.fill(1);
+
+    auto result = threadPool.addTask([values]
+    {
+      return std::accumulate(values.begin(), values.end(), 0);
+    });
+
+    REQUIRE(result.get() == 64);
+  }
+
+  SECTION("Parked workers wake up for new tasks")
+  {
+    // Give workers time to run out of spinning and go to sleep
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+
+    std::atomic<std::size_t> counter{0};
+    std::vector<std::future<void>> results;
+
+    for (std::size_t i = 0; i < 100u; ++i)
+    {
+      results.emplace_back(threadPool.addTask([& counter] { ++counter; }));
+    }
+
+    for (auto & result : results)
+    {
+      result.get();
+    }
+
+    REQUIRE(counter == 100u);
+  }
+
+  SECTION("A range of tasks is submitted at once")
+  {
+    std::atomic<std::size_t> counter{0};
+    std::vector<std::function<void()>> batch(200, [& counter] { ++counter; });
+
+    threadPool.addTasks(batch.begin(), batch.end());
+
+    while (counter != 200u)
+    {
+      std::this_thread::yield();
+    }
+
+    REQUIRE(counter == 200u);
+  }
+
+  SECTION("Tasks submitted from workers are executed")
+  {
+    std::atomic<std::size_t> counter{0};
+    std::promise<void> allDone;
+
+    threadPool.addTask([& threadPool, & counter, & allDone]
+    {
+      for (std::size_t i = 0; i < 1000u; ++i)
+      {
+        threadPool.addTask([& counter, & allDone]
+        {
+          if (++counter == 1000u)
+          {
+            allDone.set_value();
+          }
+        });
+      }
+    });
+
+    allDone.get_future().get();
+
+    REQUIRE(counter == 1000u);
+  }
+
+  SECTION("parallelFor visits every index exactly once")
+  {
+    std::vector<std::atomic<int>> visits(10007);
+
+    for (auto & visit : visits)
+    {
+      visit = 0;
+    }
+
+    threadPool.parallelFor(0, visits.size(), 64, [& visits](std::size_t first, std::size_t last)
+    {
+      for ( ; first < last; ++first)
+      {
+        ++visits[first];
+      }
+    });
+
+    REQUIRE(std::all_of(visits.begin(), visits.end(), [](const auto & visit) { return visit == 1; }));
+  }
+
+  SECTION("Exceptions of parallelFor bodies are rethrown to the caller")
+  {
+    std::atomic<std::size_t> chunks{0};
+
+    const auto body = [& chunks](std::size_t first, std::size_t)
+    {
+      ++chunks;
+
+      if (first == 500)
+      {
+        throw std::runtime_error{"chunk failed"};
+      }
+    };
+
+    REQUIRE_THROWS_AS(threadPool.parallelFor(0, 1000, 10, body), const std::runtime_error &);
+
+    REQUIRE(chunks <= 100u);
+
+    // The pool keeps working
+    chunks = 0;
+    threadPool.parallelFor(0, 1000, 10, [& chunks](std::size_t, std::size_t) { ++chunks; });
+
+    REQUIRE(chunks == 100u);
+  }
+
+  SECTION("Affine parallelFor visits every index exactly once")
+  {
+    std::vector<std::atomic<int>> visits(10007);
+
+    for (auto & visit : visits)
+    {
+      visit = 0;
+    }
+
+    for (std::size_t i = 0; i < 10u; ++i)
+    {
+      threadPool.parallelFor(0, visits.size(), 16, [& visits](std::size_t first, std::size_t last)
+      {
+        for ( ; first < last; ++first)
+        {
+          ++visits[first];
+        }
+      }, ThreadPool::Schedule::Affine);
+    }
+
+    REQUIRE(std::all_of(visits.begin(), visits.end(), [](const auto & visit) { return visit == 10; }));
+  }
+
+  SECTION("parallelFor with given partitions visits every index exactly once")
+  {
+    std::vector<std::atomic<int>> visits(1000);
+    const std::vector<std::size_t> boundaries{ 0, 10, 10, 900, 1000 };
+
+    for (auto & visit : visits)
+    {
+      visit = 0;
+    }
+
+    threadPool.parallelFor(boundaries, 7, [& visits](std::size_t first, std::size_t last)
+    {
+      for ( ; first < last; ++first)
+      {
+        ++visits[first];
+      }
+    });
+
+    REQUIRE(std::all_of(visits.begin(), visits.end(), [](const auto & visit) { return visit == 1; }));
+  }
+
+  SECTION("Statistics are collected only when enabled")
+  {
+    const auto executedTasks = [& threadPool]
+    {
+      const auto metrics = threadPool.getMetrics();
+
+      return std::accumulate(metrics.workers.begin(), metrics.workers.end(), std::uint64_t{0},
+                             [](std::uint64_t sum, const auto & worker)
+      {
+        return sum + worker.tasksExecuted;
+      });
+    };
+
+    threadPool.addTask([] {}).get();
+
+    REQUIRE_FALSE(threadPool.isMetricsEnabled());
+    REQUIRE(executedTasks() == 0);
+
+    threadPool.setMetricsEnabled(true);
+
+    std::vector<std::future<void>> results;
+
+    for (int i = 0; i < 100; ++i)
+    {
+      results.push_back(threadPool.addTask([] {}));
+    }
+
+    for (auto & result : results)
+    {
+      result.get();
+    }
+
+    // Counters are updated right after a task finishes, which may be
+    // slightly later than its future becomes ready
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+
+    while (executedTasks() < 100 && std::chrono::steady_clock::now() < deadline)
+    {
+      std::this_thread::yield();
+    }
+
+    REQUIRE(executedTasks() == 100);
+    REQUIRE(threadPool.getMetrics().workers.size() == threadPool.getThreadsCount());
+
+    threadPool.setMetricsEnabled(false);
+    threadPool.resetMetrics();
+
+    REQUIRE(executedTasks() == 0);
+  }
+}
+
+TEST_CASE("ThreadPool active workers")
+{
+  ThreadPoolOptions options;
+
+  options.elastic = true;
+
+  ThreadPool threadPool{4, options};
+
+  SECTION("Deactivated workers still execute tasks addressed to them")
+  {
+    threadPool.setActiveWorkersCount(1);
+
+    REQUIRE(threadPool.getActiveWorkersCount() == 1);
+    REQUIRE(threadPool.addTask([] { return 1; }).get() == 1);
+
+    std::atomic<std::size_t> members{0};
+
+    threadPool.runTeam(threadPool.getMaxTeamSize(), [& members](std::size_t) { ++members; });
+
+    REQUIRE(members == 5u);
+
+    threadPool.setActiveWorkersCount(10);
+
+    REQUIRE(threadPool.getActiveWorkersCount() == 4);
+  }
+
+  SECTION("The pool shrinks when parallel regions are mostly waiting")
+  {
+    for (int i = 0; i < 200; ++i)
+    {
+      threadPool.parallelFor(0, 64, 1, [](std::size_t, std::size_t) { });
+    }
+
+    REQUIRE(threadPool.getActiveWorkersCount() < 4);
+  }
+}
+
+TEST_CASE("ThreadPool nested parallelism")
+{
+  // A single worker would deadlock if waiting threads didn't help the pool
+  ThreadPool threadPool{1};
+  std::atomic<std::size_t> counter{0};
+
+  SECTION("Tasks wait for their own subtasks")
+  {
+    ThreadPool::TaskGroup group{threadPool};
+
+    for (std::size_t i = 0; i < 4u; ++i)
+    {
+      group.run([& threadPool, & counter]
+      {
+        ThreadPool::TaskGroup subgroup{threadPool};
+
+        for (std::size_t j = 0; j < 4u; ++j)
+        {
+          subgroup.run([& counter] { ++counter; });
+        }
+
+        subgroup.wait();
+      });
+    }
+
+    group.wait();
+
+    REQUIRE(counter == 16u);
+  }
+
+  SECTION("Exceptions of tasks are rethrown by wait")
+  {
+    ThreadPool::TaskGroup group{threadPool};
+
+    for (std::size_t i = 0; i < 4u; ++i)
+    {
+      group.run([& counter, i]
+      {
+        ++counter;
+
+        if (i % 2 == 0)
+        {
+          throw std::runtime_error{"task failed"};
+        }
+      });
+    }
+
+    REQUIRE_THROWS_AS(group.wait(), const std::runtime_error &);
+    REQUIRE(counter == 4u);
+
+    // The group can be used again
+    group.run([& counter] { ++counter; });
+    group.wait();
+
+    REQUIRE(counter == 5u);
+  }
+
+  SECTION("parallelFor can be nested")
+  {
+    threadPool.parallelFor(0, 8, 1, [& threadPool, & counter](std::size_t, std::size_t)
+    {
+      threadPool.parallelFor(0, 8, 1, [& counter](std::size_t first, std::size_t last)
+      {
+        counter += last - first;
+      });
+    });
+
+    REQUIRE(counter == 64u);
+  }
+}
+
+TEST_CASE("ThreadPool background tasks")
+{
+  SECTION("Background tasks run on regular workers when they are idle")
+  {
+    ThreadPool threadPool{2};
+
+    REQUIRE(threadPool.getBackgroundThreadsCount() == 0);
+    REQUIRE(threadPool.addBackgroundTask([] { return 42; }).get() == 42);
+  }
+
+  SECTION("Reserved threads execute background tasks while workers are busy")
+  {
+    ThreadPoolOptions options;
+
+    options.backgroundThreads = 1;
+
+    ThreadPool threadPool{1, options};
+    std::promise<void> release;
+    auto blocker = threadPool.addTask([future = release.get_future()]() mutable { future.get(); });
+    auto background = threadPool.addBackgroundTask([] { return 7; });
+
+    REQUIRE(background.get() == 7);
+
+    release.set_value();
+    blocker.get();
+  }
+}
+
+TEST_CASE("ThreadPool task graph")
+{
+  ThreadPool threadPool{4};
+  ThreadPool::TaskGraph graph{threadPool};
+
+  SECTION("Nodes run after their predecessors on every run")
+  {
+    // Per-chunk pipelines: second[i] depends on first[i] only, while the
+    // last node waits for all of them
+    const std::size_t chunks = 16;
+    std::vector<std::atomic<int>> stages(chunks);
+    std::atomic<int> violations{0};
+    std::atomic<int> finished{0};
+    std::vector<ThreadPool::TaskGraph::Node> second;
+
+    for (std::size_t i = 0; i < chunks; ++i)
+    {
+      const auto first = graph.addNode([& stages, i] { stages[i] = 1; });
+
+      second.push_back(graph.addNode([& stages, & violations, i]
+      {
+        if (stages[i] != 1)
+        {
+          ++violations;
+        }
+
+        stages[i] = 2;
+      }));
+      graph.addEdge(first, second.back());
+    }
+
+    const auto last = graph.addNode([& stages, & violations, & finished]
+    {
+      if (!std::all_of(stages.begin(), stages.end(), [](const auto & stage) { return stage == 2; }))
+      {
+        ++violations;
+      }
+
+      ++finished;
+    });
+
+    for (const auto node : second)
+    {
+      graph.addEdge(node, last);
+    }
+
+    REQUIRE(graph.getNodesCount() == chunks * 2 + 1);
+
+    for (int run = 0; run < 100; ++run)
+    {
+      for (auto & stage : stages)
+      {
+        stage = 0;
+      }
+
+      graph.run();
+    }
+
+    REQUIRE(violations == 0);
+    REQUIRE(finished == 100);
+  }
+
+  SECTION("Graphs can be run from inside of the pool's tasks")
+  {
+    std::atomic<int> counter{0};
+
+    const auto root = graph.addNode([& counter] { ++counter; });
+
+    for (int i = 0; i < 8; ++i)
+    {
+      graph.addEdge(root, graph.addNode([& counter] { ++counter; }));
+    }
+
+    threadPool.addTask([& graph] { graph.run(); }).get();
+
+    REQUIRE(counter == 9);
+  }
+
+  SECTION("Exceptions of nodes are rethrown by run and skip their successors")
+  {
+    std::atomic<int> counter{0};
+    std::atomic_bool fail{true};
+
+    const auto root = graph.addNode([& counter] { ++counter; });
+    const auto failing = graph.addNode([& counter, & fail]
+    {
+      if (fail)
+      {
+        throw std::runtime_error{"node failed"};
+      }
+
+      ++counter;
+    });
+
+    graph.addEdge(root, failing);
+    graph.addEdge(failing, graph.addNode([& counter] { ++counter; }));
+
+    REQUIRE_THROWS_AS(graph.run(), const std::runtime_error &);
+    REQUIRE(counter == 1);
+
+    fail = false;
+    graph.run();
+
+    REQUIRE(counter == 4);
+  }
+}
+
+TEST_CASE("ThreadPool teams")
+{
+  ThreadPoolOptions options;
+
+  options.spinDuration = std::chrono::microseconds{0};
+
+  ThreadPool threadPool{4, options};
+  const auto teamSize = threadPool.getMaxTeamSize();
+  // Members block on the barrier, so it only fills if each of them runs on
+  // its own thread
+  Barrier barrier{teamSize, std::chrono::microseconds{0}};
+
+  SECTION("Members run concurrently while other tasks are queued")
+  {
+    std::atomic<int> tasks{0};
+    std::atomic<int> members{0};
+    const int runs = 2000;
+
+    for (int run = 0; run < runs; ++run)
+    {
+      ThreadPool::TaskGroup group{threadPool};
+
+      for (int i = 0; i < 8; ++i)
+      {
+        group.run([& tasks] { ++tasks; });
+      }
+
+      threadPool.runTeam(teamSize, [& barrier, & members](std::size_t)
+      {
+        barrier.arriveAndWait();
+        ++members;
+        barrier.arriveAndWait();
+      });
+
+      group.wait();
+    }
+
+    REQUIRE(tasks == runs * 8);
+    REQUIRE(members == runs * static_cast<int>(teamSize));
+  }
+
+  SECTION("Teams can be started from inside of the pool's tasks")
+  {
+    std::atomic<int> members{0};
+
+    threadPool.addTask([& threadPool, & members]
+    {
+      const auto size = threadPool.getMaxTeamSize();
+      Barrier innerBarrier{size};
+
+      for (int run = 0; run < 200; ++run)
+      {
+        threadPool.runTeam(size, [& innerBarrier, & members](std::size_t)
+        {
+          innerBarrier.arriveAndWait();
+          ++members;
+        });
+      }
+    }).get();
+
+    REQUIRE(members == 200 * 4);
+  }
+
+  SECTION("Teams started by different threads at once get their own workers")
+  {
+    std::atomic<int> members{0};
+    const int runs = 200;
+    const auto runTeams = [& threadPool, & members, teamSize, runs]
+    {
+      Barrier teamBarrier{teamSize, std::chrono::microseconds{0}};
+
+      for (int run = 0; run < runs; ++run)
+      {
+        threadPool.runTeam(teamSize, [& teamBarrier, & members](std::size_t)
+        {
+          teamBarrier.arriveAndWait();
+          ++members;
+        });
+      }
+    };
+
+    std::thread first{runTeams};
+    std::thread second{runTeams};
+
+    first.join();
+    second.join();
+
+    REQUIRE(members == 2 * runs * static_cast<int>(teamSize));
+  }
+
+  SECTION("Exceptions of members are rethrown once all of them finish")
+  {
+    for (std::size_t thrower = 0; thrower < teamSize; ++thrower)
+    {
+      std::atomic<std::size_t> finished{0};
+
+      REQUIRE_THROWS_AS(threadPool.runTeam(teamSize, [& finished, thrower](std::size_t member)
+      {
+        ++finished;
+
+        if (member == thrower)
+        {
+          throw std::runtime_error{"member failed"};
+        }
+      }), const std::runtime_error &);
+
+      REQUIRE(finished == teamSize);
+    }
+  }
+}
@@ -0,0 +1,152 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#ifdef __linux__
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Topology.hpp"
+
+using namespace ABM;
+
+namespace
+{
+std::vector<std::size_t> getIds(const std::vector<Topology::Cpu> & cpus)
+{
+  std::vector<std::size_t> ids;
+
+  for (const auto & cpu : cpus)
+  {
+    ids.push_back(cpu.id);
+  }
+
+  return ids;
+}
+
+#ifdef __linux__
+/**
+ * @brief Sysfs tree of a machine with two NUMA nodes of two cores each and
+ * two hardware threads per core. CPUs 0-3 are the first threads of cores
+ * 0-3, CPUs 4-7 are their siblings. Cores 0 and 1 belong to node 0
+ */
+class FakeSysfs
+{
+public:
+  FakeSysfs() : root("/tmp/abm-topology-" + std::to_string(getpid()))
+  {
+    makeDirectory(root);
+    write(root + "/online", "0-7");
+
+    for (std::size_t id = 0; id < 8; ++id)
+    {
+      const auto core = id % 4;
+      const auto node = core / 2;
+      const auto cpuPath = root + "/cpu" + std::to_string(id);
+
+      makeDirectory(cpuPath);
+      makeDirectory(cpuPath + "/topology");
+      makeDirectory(cpuPath + "/node" + std::to_string(node));
+      write(cpuPath + "/topology/core_id", std::to_string(core));
+      write(cpuPath + "/topology/physical_package_id", std::to_string(node));
+      write(cpuPath + "/topology/thread_siblings_list",
+            std::to_string(core) + "," + std::to_string(core + 4));
+    }
+  }
+
+  ~FakeSysfs()
+  {
+    for (auto path = paths.rbegin(); path != paths.rend(); ++path)
+    {
+      std::remove(path->c_str());
+    }
+  }
+
+  FakeSysfs(const FakeSysfs &) = delete;
+  FakeSysfs & operator=(const FakeSysfs &) = delete;
+
+  const std::string & getRoot() const noexcept { return root; }
+
+private:
+  void makeDirectory(const std::string & path)
+  {
+    mkdir(path.c_str(), 0700);
+    paths.push_back(path);
+  }
+
+  void write(const std::string & path, const std::string & value)
+  {
+    std::ofstream{path} << value << '\n';
+    paths.push_back(path);
+  }
+
+  const std::string root;
+  std::vector<std::string> paths;
+};
+#endif
+}
+
+TEST_CASE("Topology")
+{
+  SECTION("Parsing of CPU lists")
+  {
+    REQUIRE(Topology::parseCpuList("0") == std::vector<std::size_t>{0});
+    REQUIRE(Topology::parseCpuList("0-3") == (std::vector<std::size_t>{0, 1, 2, 3}));
+    REQUIRE(Topology::parseCpuList("0-1,4,6-7\n") == (std::vector<std::size_t>{0, 1, 4, 6, 7}));
+    REQUIRE(Topology::parseCpuList("").empty());
+  }
+
+  SECTION("Selected CPUs are never used twice")
+  {
+    const auto topology = Topology::detect();
+    const auto cpusCount = topology.getCpus().size();
+    auto ids = getIds(topology.selectCpus(cpusCount * 2, false, {}));
+
+    REQUIRE(cpusCount != 0);
+    REQUIRE(ids.size() == cpusCount);
+
+    std::sort(ids.begin(), ids.end());
+
+    REQUIRE(std::adjacent_find(ids.begin(), ids.end()) == ids.end());
+  }
+
+#ifdef __linux__
+  SECTION("Threads are spread over NUMA nodes and SMT siblings are used last")
+  {
+    const FakeSysfs sysfs;
+    const auto topology = Topology::detect(sysfs.getRoot());
+
+    REQUIRE(topology.getCpus().size() == 8);
+    REQUIRE(topology.getNodesCount() == 2);
+    REQUIRE(topology.getCpus()[1].primaryThread);
+    REQUIRE(!topology.getCpus()[5].primaryThread);
+
+    REQUIRE(getIds(topology.selectCpus(2, false, {})) == (std::vector<std::size_t>{0, 2}));
+    REQUIRE(getIds(topology.selectCpus(4, false, {})) == (std::vector<std::size_t>{0, 1, 2, 3}));
+    REQUIRE(getIds(topology.selectCpus(6, false, {})) == (std::vector<std::size_t>{0, 1, 4, 2, 3, 6}));
+    REQUIRE(topology.selectCpus(12, false, {}).size() == 8);
+  }
+
+  SECTION("Skipped SMT siblings leave extra threads without CPUs")
+  {
+    const FakeSysfs sysfs;
+    const auto topology = Topology::detect(sysfs.getRoot());
+
+    REQUIRE(getIds(topology.selectCpus(6, true, {})) == (std::vector<std::size_t>{0, 1, 2, 3}));
+  }
+
+  SECTION("Only allowed CPUs are selected")
+  {
+    const FakeSysfs sysfs;
+    const auto topology = Topology::detect(sysfs.getRoot());
+
+    REQUIRE(getIds(topology.selectCpus(8, false, {2, 3, 6})) == (std::vector<std::size_t>{2, 3, 6}));
+    // Siblings are the only threads of their cores that can be used then
+    REQUIRE(getIds(topology.selectCpus(8, true, {4, 5})) == (std::vector<std::size_t>{4, 5}));
+  }
+#endif
+}
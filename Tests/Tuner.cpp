@@ -0,0 +1,59 @@
+#include "catch.hpp"
+
+#include <chrono>
+
+#include "Tuner.hpp"
+
+using namespace ABM;
+
+TEST_CASE("Tuner")
+{
+  using std::chrono::nanoseconds;
+
+  Tuner tuner{8, std::chrono::microseconds{10}};
+  const auto system = tuner.addSystem("System");
+  const std::size_t agents = 10000;
+  const std::size_t participants = 4;
+
+  // Serial execution is measured first, then parallel one
+  auto decision = tuner.decide(system, agents, participants);
+
+  REQUIRE_FALSE(decision.parallel);
+
+  // 100 ns per agent
+  tuner.record(system, decision, agents, nanoseconds{agents * 100});
+  decision = tuner.decide(system, agents, participants);
+
+  REQUIRE(decision.parallel);
+  // Long enough chunks, but at least 4 chunks per thread
+  REQUIRE(decision.grain == 100u);
+
+  SECTION("Parallel execution is chosen when it pays off")
+  {
+    tuner.record(system, decision, agents, nanoseconds{agents * 100 / participants + 5000});
+
+    REQUIRE(tuner.decide(system, agents, participants).parallel);
+    REQUIRE(tuner.decide(system, 10, participants).parallel == false);
+  }
+
+  SECTION("Serial execution is chosen when parallel overhead is too big")
+  {
+    tuner.record(system, decision, agents, nanoseconds{agents * 100});
+
+    REQUIRE_FALSE(tuner.decide(system, agents, participants).parallel);
+  }
+
+  SECTION("The other option is tried periodically")
+  {
+    tuner.record(system, decision, agents, nanoseconds{agents * 100});
+
+    std::size_t parallelExecutions = 0;
+
+    for (int i = 0; i < 16; ++i)
+    {
+      parallelExecutions += tuner.decide(system, agents, participants).parallel ? 1 : 0;
+    }
+
+    REQUIRE(parallelExecutions == 2u);
+  }
+}
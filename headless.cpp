@@ -0,0 +1,353 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "Simulation.hpp"
+
+namespace
+{
+struct RunOptions
+{
+  ABM::SimulationOptions simulation;
+  std::size_t ticks = 1000;
+  float tickDuration = 1.f / 60.f;
+  std::string updateMode = "tuned";
+  // Empty paths stand for no output
+  std::string statsPath;
+  std::string snapshotPath;
+};
+
+const char * usage =
+  "Usage: ABMHeadless [options]\n"
+  "  --ticks N          number of ticks to simulate (1000)\n"
+  "  --tick SECONDS     simulated time of a tick (0.0166)\n"
+  "  --seed N           seed of random values (random)\n"
+  "  --population N     maximum number of agents (6000)\n"
+  "  --initial N        agents created before the first tick (0)\n"
+  "  --sources N        number of energy sources (500)\n"
+  "  --world WxH        size of the world (5000x5000)\n"
+  "  --threads N        number of worker threads, up to 256 (hardware threads)\n"
+  "  --mode NAME        update mode: tuned, graph, team or fused (tuned)\n"
+  "  --elastic          adjust the number of active threads to the load (default)\n"
+  "  --fixed            keep all of the threads active\n"
+  "  --stats PATH       write per-tick statistics as CSV\n"
+  "  --snapshot PATH    write the final state of agents as CSV\n"
+  "  --help             show this message\n";
+
+// More threads than that only add overhead of scheduling
+const std::size_t maxThreadsNumber = 256;
+
+const std::array<const char *, 4> updateModes{{ "tuned", "graph", "team", "fused" }};
+
+/**
+ * @brief Converts a whole command line value, throws on garbage
+ */
+unsigned long parseNumber(const std::string & value)
+{
+  // stoul accepts signs and wraps negative numbers around
+  if (value.empty() || !std::isdigit(static_cast<unsigned char>(value.front())))
+  {
+    throw std::invalid_argument{"not a number: " + value};
+  }
+
+  std::size_t parsed = 0;
+  const auto number = std::stoul(value, & parsed);
+
+  if (parsed != value.size())
+  {
+    throw std::invalid_argument{"not a number: " + value};
+  }
+
+  return number;
+}
+
+float parseFloat(const std::string & value)
+{
+  std::size_t parsed = 0;
+  const auto number = std::stof(value, & parsed);
+
+  if (parsed != value.size() || number <= 0)
+  {
+    throw std::invalid_argument{"not a positive number: " + value};
+  }
+
+  return number;
+}
+
+/**
+ * @brief Parses world size given as WIDTHxHEIGHT
+ */
+sf::Vector2f parseSize(const std::string & value)
+{
+  const auto separator = value.find('x');
+
+  if (separator == std::string::npos)
+  {
+    throw std::invalid_argument{"size has to be WIDTHxHEIGHT: " + value};
+  }
+
+  return { parseFloat(value.substr(0, separator)), parseFloat(value.substr(separator + 1)) };
+}
+
+/**
+ * @brief Parses command line arguments
+ * @return false if only help was requested
+ */
+bool parseArguments(int argc, char ** argv, RunOptions & options)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string name = argv[i];
+
+    if (name == "--help")
+    {
+      return false;
+    }
+
+    if (name == "--elastic" || name == "--fixed")
+    {
+      options.simulation.elastic = name == "--elastic";
+      continue;
+    }
+
+    if (i + 1 >= argc)
+    {
+      throw std::invalid_argument{"missing value of " + name};
+    }
+
+    const std::string value = argv[++i];
+
+    if (name == "--ticks")
+    {
+      options.ticks = parseNumber(value);
+    }
+    else if (name == "--tick")
+    {
+      options.tickDuration = parseFloat(value);
+    }
+    else if (name == "--seed")
+    {
+      options.simulation.seeded = true;
+      options.simulation.seed = parseNumber(value);
+    }
+    else if (name == "--population")
+    {
+      options.simulation.maxAgentsNumber = parseNumber(value);
+    }
+    else if (name == "--initial")
+    {
+      options.simulation.initialAgentsNumber = parseNumber(value);
+    }
+    else if (name == "--sources")
+    {
+      options.simulation.maxSourcesNumber = parseNumber(value);
+    }
+    else if (name == "--world")
+    {
+      options.simulation.worldSize = parseSize(value);
+    }
+    else if (name == "--threads")
+    {
+      options.simulation.threadsNumber = parseNumber(value);
+
+      if (options.simulation.threadsNumber > maxThreadsNumber)
+      {
+        throw std::invalid_argument{"at most " + std::to_string(maxThreadsNumber) +
+                                    " threads are supported: " + value};
+      }
+    }
+    else if (name == "--mode")
+    {
+      if (std::find(updateModes.begin(), updateModes.end(), value) == updateModes.end())
+      {
+        throw std::invalid_argument{"unknown update mode " + value};
+      }
+
+      options.updateMode = value;
+    }
+    else if (name == "--stats")
+    {
+      options.statsPath = value;
+    }
+    else if (name == "--snapshot")
+    {
+      options.snapshotPath = value;
+    }
+    else
+    {
+      throw std::invalid_argument{"unknown option " + name};
+    }
+  }
+
+  // Options can go in any order, so they are checked against each other
+  // once all of them are known
+  if (options.simulation.initialAgentsNumber > options.simulation.maxAgentsNumber)
+  {
+    throw std::invalid_argument{"initial number of agents exceeds the population"};
+  }
+
+  return true;
+}
+
+/**
+ * @brief Opens an output file, throws if that's not possible
+ */
+void openOutput(std::ofstream & file, const std::string & path)
+{
+  file.open(path);
+
+  if (!file)
+  {
+    throw std::runtime_error{"can't open " + path};
+  }
+}
+
+/**
+ * @brief Writes position, energy and knowledge of every agent
+ */
+void writeSnapshot(const ABM::Simulation & simulation, std::ostream & output)
+{
+  const auto & agentManager = simulation.getAgentManager();
+
+  output << "agent,x,y,energy,knowledge\n";
+
+  agentManager.forAllMatching<ABM::Harvesting>([& agentManager, & output](std::size_t index)
+  {
+    const auto & orientation = agentManager.getComponent<ABM::Orientation>(index);
+
+    output << agentManager.getComponent<ABM::Identity>(index).id << ','
+           << orientation.position.x << ',' << orientation.position.y << ','
+           << agentManager.getComponent<ABM::Energy>(index).value << ','
+           << (agentManager.matchesSignature<ABM::InfoCollection>(index) ?
+                 agentManager.getComponent<ABM::Information>(index).value.count() : 0)
+           << '\n';
+  });
+}
+
+/**
+ * @brief Returns total energy of agents and of energy sources
+ */
+std::pair<double, double> getEnergy(const ABM::Simulation & simulation)
+{
+  const auto & agentManager = simulation.getAgentManager();
+  std::pair<double, double> energy{0, 0};
+
+  agentManager.forAllMatching<ABM::Life>([& agentManager, & energy](std::size_t index)
+  {
+    energy.first += agentManager.getComponent<ABM::Energy>(index).value;
+  });
+
+  const auto & sources = simulation.getEnergySources();
+
+  for (std::size_t i = 0; i < sources.size(); ++i)
+  {
+    energy.second += sources.getCurrentLevel(i);
+  }
+
+  return energy;
+}
+
+/**
+ * @brief Simulates the requested number of ticks as fast as possible
+ */
+void run(const RunOptions & options)
+{
+  using Clock = std::chrono::steady_clock;
+  using Microseconds = std::chrono::duration<double, std::micro>;
+
+  std::ofstream stats;
+  std::ofstream snapshot;
+
+  // Fail before spending time on simulation
+  if (!options.statsPath.empty())
+  {
+    openOutput(stats, options.statsPath);
+    stats << "tick,population,agents_energy,sources_energy,duration_us\n";
+  }
+
+  if (!options.snapshotPath.empty())
+  {
+    openOutput(snapshot, options.snapshotPath);
+  }
+
+  ABM::Simulation simulation{options.simulation};
+
+  while (simulation.getUpdateModeName() != options.updateMode)
+  {
+    simulation.switchUpdateMode();
+  }
+
+  const auto start = Clock::now();
+
+  for (std::size_t tick = 0; tick < options.ticks; ++tick)
+  {
+    const auto tickStart = Clock::now();
+
+    simulation.tick(options.tickDuration);
+
+    if (stats.is_open())
+    {
+      const auto duration = Microseconds{Clock::now() - tickStart}.count();
+      const auto energy = getEnergy(simulation);
+
+      stats << tick << ',' << simulation.getAgentManager().getAgentsCount() << ','
+            << energy.first << ',' << energy.second << ',' << duration << '\n';
+    }
+  }
+
+  const auto elapsed = std::chrono::duration<double>{Clock::now() - start}.count();
+
+  if (snapshot.is_open())
+  {
+    writeSnapshot(simulation, snapshot);
+  }
+
+  std::cout << "Ticks: " << simulation.getTicksCount()
+            << "\nThreads: " << simulation.threadsNumber
+            << "\nUpdate: " << simulation.getUpdateModeName()
+            << "\nPopulation: " << simulation.getAgentManager().getAgentsCount()
+            << "\nElapsed: " << elapsed << " s"
+            << "\nTicks per second: " << (elapsed > 0 ? options.ticks / elapsed : 0)
+            << std::endl;
+}
+}
+
+int main(int argc, char ** argv)
+{
+  RunOptions options;
+
+  try
+  {
+    if (!parseArguments(argc, argv, options))
+    {
+      std::cout << usage;
+
+      return EXIT_SUCCESS;
+    }
+  }
+  catch (const std::exception & exception)
+  {
+    std::cerr << "Error: " << exception.what() << '\n' << usage;
+
+    return EXIT_FAILURE;
+  }
+
+  try
+  {
+    run(options);
+  }
+  catch (const std::exception & exception)
+  {
+    std::cerr << "Error: " << exception.what() << '\n';
+
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}